@@ -179,6 +179,8 @@ bool RideApplication::Update( BXWindow* win, unsigned long long deltaTimeUS, BXI
     if( win->input.IsKeyPressedOnce( BXInput::eKEY_ESC ) )
         return false;
 
+    ENGLowLevel::Update( &_e );
+
     const float delta_time_sec = (float)BXTime::Micro_2_Sec( deltaTimeUS );
     {
         const float sensitivity_in_pix = delta_time_sec;
@@ -4,21 +4,32 @@
 #include "../job/job.h"
 #include "../rdi_backend/rdi_backend.h"
 #include "../resource_manager/resource_manager.h"
+#include "../foundation/string_interner.h"
 
 #include "../rdix/rdix_debug_draw.h"
 
+#include <string.h>
+
 
 bool ENGLowLevel::Startup( ENGLowLevel* e, int argc, const char** argv, BXWindow* window, BXIAllocator* main_allocator )
 {
     e->allocator = main_allocator;
 
     JOB::StartUp();
+    string_interner::StartUp( main_allocator );
 
     BXFilesystemStartup( main_allocator );
     FileSys()->SetRoot( "x:/dev/assets/" );
 
     RSM::StartUp( FileSys(), main_allocator );
 
+    // watcher thread over whole asset root is for content iteration only, so it's opt in
+    for( int i = 1; i < argc; ++i )
+    {
+        if( strcmp( argv[i], "-hot_reload" ) == 0 )
+            RSM::EnableHotReload( true );
+    }
+
     ::Startup( &e->rdidev, &e->rdicmdq, window->GetSystemHandle( window ), window->width, window->height, 0, e->allocator );
 
     RDIXDebug::StartUp( e->rdidev, e->allocator );
@@ -35,6 +46,12 @@ void ENGLowLevel::Shutdown( ENGLowLevel* e )
     BXFilesystemShutdown( e->allocator );
     
     JOB::ShutDown();
+    string_interner::ShutDown();
 
     e->allocator = nullptr;
 }
+
+void ENGLowLevel::Update( ENGLowLevel* e )
+{
+    RSM::Update();
+}
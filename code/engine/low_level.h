@@ -13,4 +13,5 @@ struct ENGLowLevel
 
     static bool Startup( ENGLowLevel* e, int argc, const char** argv, BXWindow* window, BXIAllocator* main_allocator );
     static void Shutdown( ENGLowLevel* e );
+    static void Update( ENGLowLevel* e );
 };
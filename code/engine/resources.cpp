@@ -6,6 +6,7 @@
 #include "../foundation/EASTL/hash_map.h"
 #include "../foundation/thread/rw_spin_lock.h"
 #include "../foundation/hashed_string.h"
+#include "../foundation/bitset.h"
 #include "../foundation/container_allocator.h"
 #include "../foundation/io.h"
 #include "../filesystem/filesystem.h"
@@ -23,7 +24,7 @@ struct RESPathHash
 
     static RESPathHash Build( const u64 hash ) { return { hash }; }
     static RESPathHash Build( const char* str ) { return { hashed_string( str ) }; }
-    static RESPathHash Build( const RESPath& path ) { return { hashed_string( path._path.c_str() ) }; }
+    static RESPathHash Build( const RESPath& path ) { return { string_interner::hash( path._path ) }; }
 };
 
 inline bool operator == ( const RESPathHash& a, const RESPathHash& b ) { return a.hash == b.hash; }
@@ -37,9 +38,10 @@ struct RESManager::Impl
     //eastl::array<u16,MAX_TOKENS> token_generation;
     //eastl::array<RESToken, MAX_TOKENS> token;
 
-    eastl::bitset<MAX_RESOURCES>               resource_freemask;
+    hbitset_t                                  resource_used;
     eastl::array<u32, MAX_RESOURCES>           resource_generation;
     eastl::array<RESFile*, MAX_RESOURCES>      resource_file;
+    eastl::array<u32, MAX_RESOURCES>           resource_file_size;
     eastl::array<RESPath , MAX_RESOURCES>      resource_path;
     eastl::array<RESStatus::E, MAX_RESOURCES > resource_status;
     
@@ -57,9 +59,11 @@ struct RESManager::Impl
     {
         _allocator = allocator;
         file_load_allocator = _allocator;
+        hbitset::create( resource_used, MAX_RESOURCES, allocator );
     }
     void ShutDown() 
     {
+        hbitset::destroy( resource_used );
         file_load_allocator = nullptr;
         _allocator = nullptr;
     }
@@ -77,6 +81,21 @@ struct RESManager::Impl
     //    return handle_ok & generation_ok;
     //}
 };
+const RESFile* RESFileValidate( const void* data, u32 data_size, u32 payload_size, u32 payload_alignment )
+{
+    if( !data || data_size < sizeof( RESFile ) )
+        return nullptr;
+
+    const RESFile* file = (const RESFile*)data;
+    if( file->system_tag != RESFile::SYSTEM_TAG )
+        return nullptr;
+
+    if( !blob_validate::offset( data, data_size, file->payload_offset, payload_size, payload_alignment ) )
+        return nullptr;
+
+    return file;
+}
+
 inline bool IsAlive( const RESManager::Impl* impl, const RESHandle handle )
 {
     scoped_read_spin_lock_t guard( impl->resource_lock );
@@ -122,9 +141,9 @@ static RESHandle AllocateResource( RESManager::Impl* impl )
     RESHandle handle;
     {
         scoped_write_spin_lock_t guard( impl->resource_lock );
-        handle.index = impl->resource_freemask.find_first();
-        SYS_ASSERT( handle.index != impl->resource_freemask.size() );
-        impl->resource_freemask.set( handle.index );
+        handle.index = hbitset::find_first_clear( impl->resource_used );
+        SYS_ASSERT( handle.index != hbitset_t::INVALID );
+        hbitset::set( impl->resource_used, handle.index );
     }
 
     handle.generation = impl->resource_generation[handle.index];
@@ -139,7 +158,7 @@ static void FreeResource( RESManager::Impl* impl, RESHandle handle )
     if( impl->IsAlive_NoLock( handle ) )
     {
         impl->resource_generation[handle.index] += 1;
-        impl->resource_freemask.reset( handle.index );
+        hbitset::clear( impl->resource_used, handle.index );
     }
 }
 
@@ -160,7 +179,7 @@ RESHandle RESManager::IssueLoading( const RESPath& path, LoadedCallback&& callba
         scoped_write_spin_lock_t guard( impl->resource_lock );
         if( impl->IsAlive_NoLock( handle ) )
         {
-            SYS_ASSERT( !impl->resource_freemask.test( handle.index ) );
+            SYS_ASSERT( hbitset::get( impl->resource_used, handle.index ) );
             impl->resource_refcount[handle.index] += 1;
         }
         else
@@ -230,8 +249,9 @@ RESHandle RESManager::IssueLoading( const RESPath& path, LoadedCallback&& callba
             RESStatus::E status = RESStatus::eEMPTY;
             if( load_error == 0 )
             {
-                RESFile* file_data = (RESFile*)file_buffer;
-                if( file_data->system_tag != RESFile::SYSTEM_TAG )
+                // type of payload is not known here, so only its presence is checked. Data<T> checks the rest
+                RESFile* file_data = (RESFile*)RESFileValidate( file_buffer, file_size, 1, 1 );
+                if( !file_data )
                 {
                     status = RESStatus::eFAIL_NOT_RESOURCE;
                 }
@@ -239,6 +259,7 @@ RESHandle RESManager::IssueLoading( const RESPath& path, LoadedCallback&& callba
                 {
                     scoped_read_spin_lock_t guard( impl->resource_lock );
                     impl->resource_file[handle.index] = file_data;
+                    impl->resource_file_size[handle.index] = file_size;
                     status = RESStatus::eSUCCESS;
                 }
             }
@@ -285,6 +306,17 @@ const RESFile* RESManager::Data( RESHandle handle ) const
     scoped_read_spin_lock_t guard( impl->resource_lock );
     return (impl->IsAlive_NoLock( handle )) ? impl->resource_file[handle.index] : nullptr;
 }
+const RESFile* RESManager::Data( RESHandle handle, u32* size ) const
+{
+    scoped_read_spin_lock_t guard( impl->resource_lock );
+    if( !impl->IsAlive_NoLock( handle ) )
+    {
+        *size = 0;
+        return nullptr;
+    }
+    *size = impl->resource_file_size[handle.index];
+    return impl->resource_file[handle.index];
+}
 
 //
 //RESToken RESManager::Token( const RESTokenHandle& tokenid )
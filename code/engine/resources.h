@@ -2,6 +2,9 @@
 
 #include "../foundation/type.h"
 #include "../foundation/string_util.h"
+#include "../foundation/string_interner.h"
+#include "../foundation/debug.h"
+#include "../foundation/blob_builder.h"
 
 #include "../job/job.h"
 #include "functional"
@@ -12,8 +15,12 @@ struct BXIFilesystem;
 
 struct RESPath
 {
-    string_t _path;
+    interned_string_t _path;
+
+    RESPath() = default;
+    explicit RESPath( const char* path ) : _path( string_interner::intern( path ) ) {}
 };
+inline bool operator == ( const RESPath& a, const RESPath& b ) { return a._path == b._path; }
 
 
 namespace RESStatus
@@ -57,16 +64,45 @@ struct RESFile
 
     template< typename T > T* Payload()
     {
-        SYS_ASSERT( type_signature == T::type_signature );
-        return version == T::version ? TYPE_OFFSET_GET_POINTER( T, payload_offset );
+        SYS_ASSERT( type_signature == T::TAG );
+        return version == T::VERSION ? TYPE_OFFSET_GET_POINTER( T, payload_offset ) : nullptr;
     }
     template< typename T > const T* Payload() const
     {
-        SYS_ASSERT( type_signature == T::type_signature );
-        return version == T::version ? TYPE_OFFSET_GET_POINTER( T, payload_offset );
+        SYS_ASSERT( type_signature == T::TAG );
+        return version == T::VERSION ? TYPE_OFFSET_GET_POINTER( T, payload_offset ) : nullptr;
     }
 };
 
+// Writes header at the beginning of blob. Payload has to be written right after with 'RESFileLinkPayload'
+template< typename T >
+inline blob_ref_t RESFileBegin( blob_builder_t* b, u32 tag = 0 )
+{
+    SYS_ASSERT( b->size == 0 );
+    RESFile header;
+    header.tag = tag;
+    header.version = T::VERSION;
+    header.type_signature = T::TAG;
+    return blob_builder::write( b, header );
+}
+inline void RESFileLinkPayload( blob_builder_t* b, blob_ref_t header, blob_ref_t payload )
+{
+    blob_builder::link( b, blob_builder::field( header, offsetof( RESFile, payload_offset ) ), payload );
+}
+
+// Checks header and payload bounds. Returns nullptr when 'data' is not a valid resource file
+const RESFile* RESFileValidate( const void* data, u32 data_size, u32 payload_size, u32 payload_alignment );
+
+template< typename T >
+inline const T* RESFileValidate( const void* data, u32 data_size )
+{
+    const RESFile* file = RESFileValidate( data, data_size, sizeof( T ), ALIGNOF( T ) );
+    if( !file || file->type_signature != T::TAG || file->version != T::VERSION )
+        return nullptr;
+
+    return file->Payload<T>();
+}
+
 
 
 //struct RESToken
@@ -91,6 +127,16 @@ struct RESManager
     void Unload( const RESHandle& handle );
 
     const RESFile* Data( RESHandle handle ) const;
+    const RESFile* Data( RESHandle handle, u32* size ) const;
+
+    // payload is checked against T (tag, version, size and alignment). Returns nullptr when it doesn't match
+    template< typename T >
+    const T* Data( RESHandle handle ) const
+    {
+        u32 size = 0;
+        const RESFile* file = Data( handle, &size );
+        return (file) ? RESFileValidate<T>( file, size ) : nullptr;
+    }
 
     //RESToken Token( const RESTokenHandle& tokenid );
     //RESHandle ReleaseToken( RESHandle tokenid );
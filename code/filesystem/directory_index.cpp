@@ -0,0 +1,635 @@
+#include "directory_index.h"
+#include "filesystem.h"
+
+#include "../memory/memory.h"
+#include "../foundation/array.h"
+#include "../foundation/common.h"
+#include "../foundation/hashmap.h"
+#include "../foundation/hashed_string.h"
+#include "../foundation/string_util.h"
+#include "../foundation/tag.h"
+#include "../foundation/io.h"
+#include "../util/file_system_name.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+struct DirIndexFile
+{
+    uint64_t path_hash;
+    uint64_t size;
+    uint64_t mtime;
+    uint32_t name_offset;
+    uint32_t name_length;
+};
+
+struct DirIndexDir
+{
+    uint64_t path_hash;
+    uint64_t mtime;
+    uint32_t path_offset; // relative path with trailing '/'. Root is empty string
+    uint32_t path_length;
+    uint32_t first_file;
+    uint32_t nb_files;
+    uint32_t first_child;
+    uint32_t nb_children;
+};
+
+struct DirIndexFileHeader
+{
+    static constexpr uint32_t TAG = BX_UTIL_TAG32( 'D', 'I', 'D', 'X' );
+    static constexpr uint32_t VERSION = BX_UTIL_MAKE_VERSION( 1, 0, 0 );
+
+    uint32_t tag = TAG;
+    uint32_t version = VERSION;
+    uint32_t nb_dirs = 0;
+    uint32_t nb_files = 0;
+    uint32_t nb_children = 0;
+    uint32_t names_size = 0;
+};
+
+struct BXDirectoryIndex
+{
+    FSName root;
+
+    array_t<DirIndexDir>  dirs;
+    array_t<DirIndexFile> files;
+    array_t<uint32_t>     children;
+    array_t<char>         names;
+
+    hash_t<uint32_t> dir_lookup;
+    hash_t<uint32_t> file_lookup;
+
+    BXIAllocator* allocator = nullptr;
+
+    BXDirectoryIndex( BXIAllocator* a )
+        : dirs( a ), files( a ), children( a ), names( a )
+        , dir_lookup( a ), file_lookup( a ), allocator( a )
+    {}
+
+    const char* Name( uint32_t offset ) const { return names.begin() + offset; }
+};
+
+static constexpr uint32_t INVALID_DIR_INDEX = UINT32_MAX;
+
+static uint32_t AppendName( array_t<char>& names, const char* str, uint32_t len )
+{
+    const uint32_t offset = names.size;
+    const uint32_t required = offset + len + 1;
+    if( required > names.capacity )
+    {
+        array::reserve( names, (int)max_of_2( names.capacity * 2, required ) );
+    }
+    array::resize( names, (int)required );
+    memcpy( names.begin() + offset, str, len );
+    names[offset + len] = 0;
+    return offset;
+}
+
+static inline uint64_t ToU64( const FILETIME& ft )
+{
+    return ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+}
+
+// converts to form used in the index: forward slashes, directory paths end with '/'
+static uint32_t NormalizePath( char( &dst )[FSName::MAX_SIZE], const char* relative_path, bool is_directory )
+{
+    uint32_t len = 0;
+    for( const char* c = relative_path; *c && len < FSName::MAX_LENGTH - 1; ++c )
+    {
+        dst[len++] = (*c == '\\') ? '/' : *c;
+    }
+    if( is_directory && len && dst[len - 1] != '/' )
+    {
+        dst[len++] = '/';
+    }
+    dst[len] = 0;
+    return len;
+}
+
+// --- crawler
+struct DirScan
+{
+    char     path[FSName::MAX_SIZE] = {};
+    uint32_t path_length = 0;
+    uint64_t mtime = 0;
+    bool     failed = false; // directory couldn't be read, entries are taken from previous index
+
+    array_t<DirIndexFile> files;
+    array_t<char>         names;
+
+    DirScan( BXIAllocator* a ) : files( a ), names( a ) {}
+};
+
+struct DirCrawler
+{
+    const BXDirectoryIndex* index = nullptr;
+    BXIAllocator* allocator = nullptr;
+
+    std::mutex              lock;
+    std::condition_variable cv;
+    array_t<DirScan*>       queue;
+    array_t<DirScan*>       done;
+    uint32_t                nb_pending = 0;
+    std::atomic_uint32_t    nb_rescanned = 0;
+    std::atomic_uint32_t    nb_failed = 0;
+
+    DirCrawler( const BXDirectoryIndex* i, BXIAllocator* a )
+        : index( i ), allocator( a ), queue( a ), done( a )
+    {}
+};
+
+static void PushDirectory( DirCrawler* crawler, const char* parent_path, uint32_t parent_length, const char* name, uint32_t name_length )
+{
+    const uint32_t length = parent_length + name_length + ((name_length) ? 1 : 0);
+    if( length >= FSName::MAX_LENGTH )
+    {
+        SYS_LOG_ERROR( "DirectoryIndex: path '%s%s' is to long", parent_path, name );
+        return;
+    }
+
+    DirScan* scan = BX_NEW( crawler->allocator, DirScan, crawler->allocator );
+    memcpy( scan->path, parent_path, parent_length );
+    if( name_length )
+    {
+        memcpy( scan->path + parent_length, name, name_length );
+        scan->path[length - 1] = '/';
+    }
+    scan->path[length] = 0;
+    scan->path_length = length;
+
+    {
+        std::lock_guard<std::mutex> guard( crawler->lock );
+        array::push_back( crawler->queue, scan );
+        crawler->nb_pending += 1;
+    }
+    crawler->cv.notify_one();
+}
+
+// copies entries of directory from previous index and queues its children
+static void KeepPrevious( DirCrawler* crawler, DirScan* scan, uint32_t old_index )
+{
+    const BXDirectoryIndex* index = crawler->index;
+    const DirIndexDir& old_dir = index->dirs[old_index];
+    scan->mtime = old_dir.mtime;
+    for( uint32_t i = 0; i < old_dir.nb_files; ++i )
+    {
+        DirIndexFile file = index->files[old_dir.first_file + i];
+        file.name_offset = AppendName( scan->names, index->Name( file.name_offset ), file.name_length );
+        array::push_back( scan->files, file );
+    }
+    for( uint32_t i = 0; i < old_dir.nb_children; ++i )
+    {
+        const DirIndexDir& child = index->dirs[index->children[old_dir.first_child + i]];
+        const char* child_name = index->Name( child.path_offset ) + old_dir.path_length;
+        const uint32_t child_name_length = child.path_length - old_dir.path_length - 1;
+        PushDirectory( crawler, scan->path, scan->path_length, child_name, child_name_length );
+    }
+}
+
+// Directory which can't be read (e.g. transient sharing violation) keeps its previous entries, so its subtree
+// doesn't disappear from index. Without previous entries it stays empty with mtime 0, so next update reads it again
+static void ScanFailed( DirCrawler* crawler, DirScan* scan, uint32_t old_index )
+{
+    scan->failed = true;
+    crawler->nb_failed += 1;
+    array::clear( scan->files );
+    array::clear( scan->names );
+    scan->mtime = 0;
+    if( old_index != INVALID_DIR_INDEX )
+    {
+        KeepPrevious( crawler, scan, old_index );
+    }
+}
+
+static void ScanDirectory( DirCrawler* crawler, DirScan* scan )
+{
+    const BXDirectoryIndex* index = crawler->index;
+
+    const uint64_t path_hash = hashed_string( scan->path );
+    const uint32_t old_index = hash::get( index->dir_lookup, path_hash, INVALID_DIR_INDEX );
+
+    FSName abs_path;
+    abs_path.Append( index->root.AbsolutePath() );
+    if( !abs_path.Append( scan->path ) )
+    {
+        SYS_LOG_ERROR( "DirectoryIndex: path '%s' is to long", scan->path );
+        ScanFailed( crawler, scan, old_index );
+        return;
+    }
+
+    WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+    if( !GetFileAttributesExA( abs_path.AbsolutePath(), GetFileExInfoStandard, &attributes ) )
+    {
+        ScanFailed( crawler, scan, old_index );
+        return;
+    }
+
+    scan->mtime = ToU64( attributes.ftLastWriteTime );
+
+    if( old_index != INVALID_DIR_INDEX && index->dirs[old_index].mtime == scan->mtime )
+    {
+        KeepPrevious( crawler, scan, old_index );
+        return;
+    }
+
+    crawler->nb_rescanned += 1;
+
+    if( !abs_path.Append( "*" ) )
+    {
+        ScanFailed( crawler, scan, old_index );
+        return;
+    }
+
+    WIN32_FIND_DATAA find_data = {};
+    HANDLE hfind = FindFirstFileExA( abs_path.AbsolutePath(), FindExInfoBasic, &find_data, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH );
+    if( hfind == INVALID_HANDLE_VALUE )
+    {
+        ScanFailed( crawler, scan, old_index );
+        return;
+    }
+
+    char file_path[FSName::MAX_SIZE];
+    memcpy( file_path, scan->path, scan->path_length );
+    do
+    {
+        const char* name = find_data.cFileName;
+        const uint32_t name_length = string::length( name );
+        const bool dot = name_length == 1 && name[0] == '.';
+        const bool dotdot = name_length == 2 && name[0] == '.' && name[1] == '.';
+        if( dot || dotdot )
+            continue;
+
+        if( find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY )
+        {
+            PushDirectory( crawler, scan->path, scan->path_length, name, name_length );
+        }
+        else if( scan->path_length + name_length < FSName::MAX_LENGTH )
+        {
+            memcpy( file_path + scan->path_length, name, name_length + 1 );
+
+            DirIndexFile file;
+            file.path_hash = hashed_string( file_path );
+            file.size = ((uint64_t)find_data.nFileSizeHigh << 32) | find_data.nFileSizeLow;
+            file.mtime = ToU64( find_data.ftLastWriteTime );
+            file.name_offset = AppendName( scan->names, name, name_length );
+            file.name_length = name_length;
+            array::push_back( scan->files, file );
+        }
+    } while( FindNextFileA( hfind, &find_data ) );
+
+    FindClose( hfind );
+}
+
+static void CrawlerThread( DirCrawler* crawler )
+{
+    while( true )
+    {
+        DirScan* scan = nullptr;
+        {
+            std::unique_lock<std::mutex> guard( crawler->lock );
+            crawler->cv.wait( guard, [crawler]() { return !array::empty( crawler->queue ) || crawler->nb_pending == 0; } );
+            if( array::empty( crawler->queue ) )
+                break;
+
+            scan = array::back( crawler->queue );
+            array::pop_back( crawler->queue );
+        }
+
+        ScanDirectory( crawler, scan );
+
+        bool finished = false;
+        {
+            std::lock_guard<std::mutex> guard( crawler->lock );
+            array::push_back( crawler->done, scan );
+            finished = --crawler->nb_pending == 0;
+        }
+        if( finished )
+        {
+            crawler->cv.notify_all();
+        }
+    }
+}
+
+// --- index
+static void Rebuild( BXDirectoryIndex* index )
+{
+    hash::clear( index->dir_lookup );
+    hash::clear( index->file_lookup );
+    hash::reserve( index->dir_lookup, array::size( index->dirs ) * 2 + 1 );
+    hash::reserve( index->file_lookup, array::size( index->files ) * 2 + 1 );
+
+    for( uint32_t i = 0; i < array::size( index->dirs ); ++i )
+    {
+        hash::set( index->dir_lookup, index->dirs[i].path_hash, i );
+    }
+    for( uint32_t i = 0; i < array::size( index->files ); ++i )
+    {
+        hash::set( index->file_lookup, index->files[i].path_hash, i );
+    }
+}
+
+static void Clear( BXDirectoryIndex* index )
+{
+    array::clear( index->dirs );
+    array::clear( index->files );
+    array::clear( index->children );
+    array::clear( index->names );
+    hash::clear( index->dir_lookup );
+    hash::clear( index->file_lookup );
+}
+
+BXDirectoryIndex* DirectoryIndexCreate( const char* absolute_root, BXIAllocator* allocator )
+{
+    BXDirectoryIndex* index = BX_NEW( allocator, BXDirectoryIndex, allocator );
+    const bool bres = index->root.Append( absolute_root );
+    SYS_ASSERT( bres );
+    return index;
+}
+
+void DirectoryIndexDestroy( BXDirectoryIndex** index )
+{
+    if( !index[0] )
+        return;
+
+    BXIAllocator* allocator = index[0]->allocator;
+    BX_DELETE0( allocator, index[0] );
+}
+
+uint32_t DirectoryIndexUpdate( BXDirectoryIndex* index, uint32_t nb_threads )
+{
+    if( nb_threads == 0 )
+        nb_threads = max_of_2( 1u, std::thread::hardware_concurrency() );
+
+    DirCrawler crawler( index, index->allocator );
+    PushDirectory( &crawler, "", 0, "", 0 );
+
+    std::thread* threads = (std::thread*)BX_MALLOC( index->allocator, sizeof( std::thread ) * nb_threads, ALIGNOF( std::thread ) );
+    for( uint32_t i = 0; i < nb_threads; ++i )
+    {
+        new(&threads[i]) std::thread( CrawlerThread, &crawler );
+    }
+    for( uint32_t i = 0; i < nb_threads; ++i )
+    {
+        threads[i].join();
+        threads[i].~thread();
+    }
+    BX_FREE( index->allocator, threads );
+
+    // parents go before children, so each directory can find its parent among already added ones
+    std::sort( crawler.done.begin(), crawler.done.end(), []( const DirScan* a, const DirScan* b )
+    {
+        return strcmp( a->path, b->path ) < 0;
+    } );
+
+    const uint32_t nb_dirs = array::size( crawler.done );
+
+    array_t<DirIndexDir>  dirs( index->allocator );
+    array_t<DirIndexFile> files( index->allocator );
+    array_t<char>         names( index->allocator );
+    array_t<uint32_t>     parents( index->allocator );
+    hash_t<uint32_t>      lookup( index->allocator );
+    array::reserve( dirs, (int)nb_dirs );
+    array::reserve( parents, (int)nb_dirs );
+    hash::reserve( lookup, nb_dirs * 2 + 1 );
+
+    for( uint32_t i = 0; i < nb_dirs; ++i )
+    {
+        const DirScan* scan = crawler.done[i];
+
+        DirIndexDir dir = {};
+        dir.path_hash = hashed_string( scan->path );
+        dir.mtime = scan->mtime;
+        dir.path_offset = AppendName( names, scan->path, scan->path_length );
+        dir.path_length = scan->path_length;
+        dir.first_file = array::size( files );
+        dir.nb_files = array::size( scan->files );
+        for( const DirIndexFile& scan_file : scan->files )
+        {
+            DirIndexFile file = scan_file;
+            file.name_offset = AppendName( names, scan->names.begin() + scan_file.name_offset, scan_file.name_length );
+            array::push_back( files, file );
+        }
+
+        uint32_t parent = INVALID_DIR_INDEX;
+        if( scan->path_length )
+        {
+            uint32_t parent_length = scan->path_length - 1;
+            while( parent_length && scan->path[parent_length - 1] != '/' )
+                --parent_length;
+
+            char parent_path[FSName::MAX_SIZE];
+            memcpy( parent_path, scan->path, parent_length );
+            parent_path[parent_length] = 0;
+            parent = hash::get( lookup, hashed_string( parent_path ), INVALID_DIR_INDEX );
+        }
+
+        hash::set( lookup, dir.path_hash, array::size( dirs ) );
+        array::push_back( dirs, dir );
+        array::push_back( parents, parent );
+    }
+
+    // children are stored as contiguous ranges
+    for( uint32_t i = 0; i < nb_dirs; ++i )
+    {
+        if( parents[i] != INVALID_DIR_INDEX )
+            dirs[parents[i]].nb_children += 1;
+    }
+    uint32_t first_child = 0;
+    for( uint32_t i = 0; i < nb_dirs; ++i )
+    {
+        dirs[i].first_child = first_child;
+        first_child += dirs[i].nb_children;
+        dirs[i].nb_children = 0;
+    }
+    array::clear( index->children );
+    array::resize( index->children, (int)first_child );
+    for( uint32_t i = 0; i < nb_dirs; ++i )
+    {
+        if( parents[i] != INVALID_DIR_INDEX )
+        {
+            DirIndexDir& parent = dirs[parents[i]];
+            index->children[parent.first_child + parent.nb_children++] = i;
+        }
+    }
+
+    for( DirScan* scan : crawler.done )
+    {
+        BX_DELETE( index->allocator, scan );
+    }
+
+    array::destroy( index->dirs );
+    array::destroy( index->files );
+    array::destroy( index->names );
+    index->dirs = std::move( dirs );
+    index->files = std::move( files );
+    index->names = std::move( names );
+    Rebuild( index );
+
+    if( crawler.nb_failed )
+    {
+        SYS_LOG_WARNING( "DirectoryIndex: %u directories couldn't be read, previous entries are kept", (uint32_t)crawler.nb_failed );
+    }
+
+    return crawler.nb_rescanned;
+}
+
+bool DirectoryIndexLoad( BXDirectoryIndex* index, const char* absolute_path )
+{
+    uint8_t* buffer = nullptr;
+    uint32_t size = 0;
+    if( ReadFile( &buffer, &size, absolute_path, index->allocator ) != IO_OK )
+        return false;
+
+    bool result = false;
+    const DirIndexFileHeader* header = (const DirIndexFileHeader*)buffer;
+    if( size >= sizeof( DirIndexFileHeader ) && header->tag == DirIndexFileHeader::TAG && header->version == DirIndexFileHeader::VERSION )
+    {
+        const uint64_t expected_size = sizeof( DirIndexFileHeader )
+            + (uint64_t)header->nb_dirs * sizeof( DirIndexDir )
+            + (uint64_t)header->nb_files * sizeof( DirIndexFile )
+            + (uint64_t)header->nb_children * sizeof( uint32_t )
+            + header->names_size;
+
+        if( expected_size == size )
+        {
+            Clear( index );
+            const uint8_t* ptr = buffer + sizeof( DirIndexFileHeader );
+
+            array::resize( index->dirs, (int)header->nb_dirs );
+            memcpy( index->dirs.begin(), ptr, header->nb_dirs * sizeof( DirIndexDir ) );
+            ptr += header->nb_dirs * sizeof( DirIndexDir );
+
+            array::resize( index->files, (int)header->nb_files );
+            memcpy( index->files.begin(), ptr, header->nb_files * sizeof( DirIndexFile ) );
+            ptr += header->nb_files * sizeof( DirIndexFile );
+
+            array::resize( index->children, (int)header->nb_children );
+            memcpy( index->children.begin(), ptr, header->nb_children * sizeof( uint32_t ) );
+            ptr += header->nb_children * sizeof( uint32_t );
+
+            array::resize( index->names, (int)header->names_size );
+            memcpy( index->names.begin(), ptr, header->names_size );
+
+            Rebuild( index );
+            result = true;
+        }
+    }
+
+    if( !result )
+    {
+        SYS_LOG_WARNING( "DirectoryIndex: '%s' is not valid index file", absolute_path );
+    }
+
+    BX_FREE( index->allocator, buffer );
+    return result;
+}
+
+bool DirectoryIndexSave( const BXDirectoryIndex* index, const char* absolute_path )
+{
+    DirIndexFileHeader header;
+    header.nb_dirs = array::size( index->dirs );
+    header.nb_files = array::size( index->files );
+    header.nb_children = array::size( index->children );
+    header.names_size = array::size( index->names );
+
+    const uint32_t size = sizeof( DirIndexFileHeader )
+        + array::size_in_bytes( index->dirs )
+        + array::size_in_bytes( index->files )
+        + array::size_in_bytes( index->children )
+        + array::size_in_bytes( index->names );
+
+    uint8_t* buffer = (uint8_t*)BX_MALLOC( index->allocator, size, 8 );
+    uint8_t* ptr = buffer;
+    memcpy( ptr, &header, sizeof( header ) );                                         ptr += sizeof( header );
+    memcpy( ptr, index->dirs.begin(), array::size_in_bytes( index->dirs ) );         ptr += array::size_in_bytes( index->dirs );
+    memcpy( ptr, index->files.begin(), array::size_in_bytes( index->files ) );       ptr += array::size_in_bytes( index->files );
+    memcpy( ptr, index->children.begin(), array::size_in_bytes( index->children ) ); ptr += array::size_in_bytes( index->children );
+    memcpy( ptr, index->names.begin(), array::size_in_bytes( index->names ) );       ptr += array::size_in_bytes( index->names );
+    SYS_ASSERT( ptr == buffer + size );
+
+    const int written = WriteFile( absolute_path, buffer, size );
+    BX_FREE( index->allocator, buffer );
+
+    return written == (int)size;
+}
+
+uint32_t DirectoryIndexFileCount( const BXDirectoryIndex* index )
+{
+    return array::size( index->files );
+}
+
+bool DirectoryIndexFind( BXDirectoryIndexEntry* entry, const BXDirectoryIndex* index, const char* relative_path )
+{
+    char path[FSName::MAX_SIZE];
+    NormalizePath( path, relative_path, false );
+
+    const uint32_t i = hash::get( index->file_lookup, hashed_string( path ), INVALID_DIR_INDEX );
+    if( i == INVALID_DIR_INDEX )
+        return false;
+
+    const DirIndexFile& file = index->files[i];
+    entry->path_hash = file.path_hash;
+    entry->size = file.size;
+    entry->mtime = file.mtime;
+    return true;
+}
+
+static void ListDirectory( string_buffer_t* s, const BXDirectoryIndex* index, uint32_t dir_index, uint32_t flags )
+{
+    const bool append_relative_name = (flags & BXEFileListFlag::ONLY_NAMES) == 0;
+    const DirIndexDir& dir = index->dirs[dir_index];
+    const char* dir_path = index->Name( dir.path_offset );
+
+    for( uint32_t i = 0; i < dir.nb_files; ++i )
+    {
+        const DirIndexFile& file = index->files[dir.first_file + i];
+        string::append( s, "F" );
+        if( append_relative_name && dir.path_length )
+        {
+            string::appendn( s, dir_path, dir.path_length - 1, '/' );
+        }
+        string::appendn( s, index->Name( file.name_offset ), file.name_length );
+    }
+
+    for( uint32_t i = 0; i < dir.nb_children; ++i )
+    {
+        const uint32_t child_index = index->children[dir.first_child + i];
+        const DirIndexDir& child = index->dirs[child_index];
+
+        string::append( s, "D+" );
+        if( append_relative_name && dir.path_length )
+        {
+            string::appendn( s, dir_path, dir.path_length - 1, '/' );
+        }
+        string::appendn( s, index->Name( child.path_offset ) + dir.path_length, child.path_length - dir.path_length - 1 );
+        if( flags & BXEFileListFlag::RECURSE )
+        {
+            ListDirectory( s, index, child_index, flags );
+        }
+        string::append( s, "D-" );
+    }
+}
+
+void DirectoryIndexList( string_buffer_t* s, const BXDirectoryIndex* index, const char* relative_path, uint32_t flags )
+{
+    char path[FSName::MAX_SIZE];
+    NormalizePath( path, relative_path, true );
+
+    const uint32_t dir_index = hash::get( index->dir_lookup, hashed_string( path ), INVALID_DIR_INDEX );
+    if( dir_index != INVALID_DIR_INDEX )
+    {
+        ListDirectory( s, index, dir_index, flags );
+    }
+}
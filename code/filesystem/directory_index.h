@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+struct BXIAllocator;
+struct string_buffer_t;
+
+struct BXDirectoryIndexEntry
+{
+    uint64_t path_hash = 0; // hashed_string of path relative to root
+    uint64_t size = 0;
+    uint64_t mtime = 0;
+};
+
+// Persistent listing of all files under root directory.
+// Update reads from disk only directories which mtime has changed since previous update,
+// so index loaded from file makes startup listing almost free.
+// Note: directory mtime changes when entries are added, removed or renamed, but not when file content changes.
+struct BXDirectoryIndex;
+
+BXDirectoryIndex* DirectoryIndexCreate( const char* absolute_root, BXIAllocator* allocator );
+void              DirectoryIndexDestroy( BXDirectoryIndex** index );
+
+bool     DirectoryIndexLoad( BXDirectoryIndex* index, const char* absolute_path );
+bool     DirectoryIndexSave( const BXDirectoryIndex* index, const char* absolute_path );
+
+// crawls root with 'nb_threads' threads (0 - hardware concurrency). Returns number of directories read from disk.
+// Directory which can't be read keeps entries from previous update
+uint32_t DirectoryIndexUpdate( BXDirectoryIndex* index, uint32_t nb_threads = 0 );
+
+uint32_t DirectoryIndexFileCount( const BXDirectoryIndex* index );
+bool     DirectoryIndexFind( BXDirectoryIndexEntry* entry, const BXDirectoryIndex* index, const char* relative_path );
+
+// output has the same format as ListFiles
+void     DirectoryIndexList( string_buffer_t* s, const BXDirectoryIndex* index, const char* relative_path, uint32_t flags );
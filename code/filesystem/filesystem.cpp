@@ -35,11 +35,8 @@ static BXFileWaitResult LoadFileSyncImpl( BXIFilesystem* fs, const char * relati
 	BXFileWaitResult result;
 	result.handle = fs->LoadFile( relativePath, mode, allocator );
 
+	fs->Wait( result.handle );
 	result.status = fs->File( &result.file, result.handle );
-	while( result.status == BXEFileStatus::LOADING )
-	{
-		result.status = fs->File( &result.file, result.handle );
-	}
 	return result;
 }
 static int32_t WriteFileSyncImpl( BXIFilesystem* fs, const char* relative_path, const void* data, uint32_t data_size )
@@ -56,11 +53,21 @@ BXFileWaitResult LoadFileSync( const char* relativePath, BXEFIleMode::E mode, BX
     return LoadFileSyncImpl( __filesys, relativePath, mode, allocator );
 }
 
-inline int32_t WriteFileSync( const char* relativePath, const void* data, uint32_t data_size )
+int32_t WriteFileSync( const char* relativePath, const void* data, uint32_t data_size )
 {
     return WriteFileSyncImpl( __filesys, relativePath, data, data_size );
 }
 
+void WriteFileAsync( const char* relativePath, const void* data, uint32_t data_size )
+{
+    __filesys->WriteFileAsync( relativePath, data, data_size );
+}
+
+uint32_t FlushWrites()
+{
+    return __filesys->FlushWrites();
+}
+
 static void AppendRelativePath( string_buffer_t* s, const char* relative_path )
 {
     uint32_t len = string::length( relative_path );
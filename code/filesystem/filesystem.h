@@ -25,6 +25,7 @@ namespace BXEFIleMode
     {
         TXT,
         BIN,
+        STREAM,
     };
 }//
 
@@ -37,6 +38,9 @@ namespace BXEFileListFlag
     };
 }//
 
+static constexpr uint32_t BX_FILE_WAIT_INFINITE = UINT32_MAX;
+static constexpr uint32_t BX_FILE_WAIT_TIMEOUT = UINT32_MAX;
+
 struct BXFile
 {
 	union
@@ -71,6 +75,38 @@ struct BXPostLoadCallback
     BXPostLoadCallback() = default;
 };
 
+// called on I/O thread for each chunk of streamed file. Returning false aborts streaming and file ends up as NOT_FOUND.
+// Read of next chunk is in flight while callback runs, but other files wait for it, so it should be cheap.
+// Empty file gets one call with chunk = nullptr and all sizes 0
+struct BXStreamChunkCallback
+{
+    typedef bool( *CallbackFunction )(BXIFilesystem* filesystem, BXFileHandle hfile, const void* chunk, uint32_t chunk_size, uint32_t offset, uint32_t total_size, void* user_data0, void* user_data1, void* user_data2 );
+    CallbackFunction callback = nullptr;
+    void* user_data0 = nullptr;
+    void* user_data1 = nullptr;
+    void* user_data2 = nullptr;
+
+    BXStreamChunkCallback( CallbackFunction cb, void* ud0, void* ud1 = nullptr, void* ud2 = nullptr )
+        : callback( cb ), user_data0( ud0 ), user_data1( ud1 ), user_data2( ud2 ) {}
+
+    BXStreamChunkCallback() = default;
+};
+
+// called once when every file of a batch has been processed. Status of each file can be queried with BXIFilesystem::File
+struct BXPostLoadBatchCallback
+{
+    typedef void( *CallbackFunction )(BXIFilesystem* filesystem, const BXFileHandle* hfiles, uint32_t count, void* user_data0, void* user_data1, void* user_data2 );
+    CallbackFunction callback = nullptr;
+    void* user_data0 = nullptr;
+    void* user_data1 = nullptr;
+    void* user_data2 = nullptr;
+
+    BXPostLoadBatchCallback( CallbackFunction cb, void* ud0, void* ud1 = nullptr, void* ud2 = nullptr )
+        : callback( cb ), user_data0( ud0 ), user_data1( ud1 ), user_data2( ud2 ) {}
+
+    BXPostLoadBatchCallback() = default;
+};
+
 // --- 
 struct string_buffer_t;
 struct BXIFilesystem
@@ -81,9 +117,37 @@ struct BXIFilesystem
     virtual const char*      GetRoot  () const = 0;
 	virtual BXFileHandle	 LoadFile ( const char* relativePath, BXEFIleMode::E mode, BXPostLoadCallback callback, BXIAllocator* allocator = nullptr ) = 0;
     virtual BXFileHandle	 LoadFile ( const char* relativePath, BXEFIleMode::E mode, BXIAllocator* allocator = nullptr ) { return LoadFile( relativePath, mode, BXPostLoadCallback{ nullptr,nullptr }, allocator ); }
+    
+    // queues all files at once. Files are read in on-disk order, not in 'relativePaths' order.
+    // 'out_handles' has to be able to hold 'count' handles and is filled in 'relativePaths' order
+    virtual bool             LoadFiles( BXFileHandle* out_handles, const char* const* relativePaths, uint32_t count, BXEFIleMode::E mode, BXPostLoadBatchCallback callback, BXIAllocator* allocator = nullptr ) = 0;
+    
+    // file data is delivered in 'chunk_size' pieces to 'chunk_callback' instead of being loaded into one buffer.
+    // Once streaming is done file status is READY (with no data) or NOT_FOUND and 'callback' is called
+    virtual BXFileHandle     StreamFile( const char* relativePath, uint32_t chunk_size, BXStreamChunkCallback chunk_callback, BXPostLoadCallback callback, BXIAllocator* allocator = nullptr ) = 0;
     virtual void			 CloseFile( BXFileHandle* fhandle, bool freeData = true ) = 0;
 	
 	virtual BXEFileStatus::E File     ( BXFile* file, BXFileHandle fhandle ) = 0;
+
+    // data is copied and written on I/O thread to temporary file which is then renamed over destination,
+    // so nobody sees partially written file. Pending writes to the same path are coalesced (last one wins)
+    virtual void             WriteFileAsync( const char* relativePath, const void* data, uint32_t data_size ) = 0;
+    // blocks until all writes queued before the call are done. Returns number of writes which failed since previous flush
+    virtual uint32_t         FlushWrites() = 0;
+
+    // block calling thread until file(s) are not LOADING anymore. Invalid handles are treated as done.
+    // Wait returns status of file (LOADING on timeout)
+    // WaitAll returns false on timeout
+    // WaitAny returns index of finished handle or BX_FILE_WAIT_TIMEOUT
+    virtual BXEFileStatus::E Wait   ( BXFileHandle fhandle, uint32_t timeout_ms = BX_FILE_WAIT_INFINITE ) = 0;
+    virtual bool             WaitAll( const BXFileHandle* fhandles, uint32_t count, uint32_t timeout_ms = BX_FILE_WAIT_INFINITE ) = 0;
+    virtual uint32_t         WaitAny( const BXFileHandle* fhandles, uint32_t count, uint32_t timeout_ms = BX_FILE_WAIT_INFINITE ) = 0;
+
+    // starts (or stops) watching whole root directory tree for changed files
+    virtual bool             WatchChanges( bool enable ) = 0;
+    // appends relative path of every file changed since previous call to 's'. Returns number of files.
+    // File is reported once it was not touched for a moment, so files which are still being written are not reported
+    virtual uint32_t         PollChanges( string_buffer_t* s ) = 0;
 };
 extern BXIFilesystem* FileSys();
 void BXFilesystemStartup( BXIAllocator* allocator );
@@ -91,5 +155,7 @@ void BXFilesystemShutdown( BXIAllocator* allocator );
 
 BXFileWaitResult LoadFileSync( const char* relativePath, BXEFIleMode::E mode, BXIAllocator* allocator );
 int32_t          WriteFileSync( const char* relativePath, const void* data, uint32_t data_size );
+void             WriteFileAsync( const char* relativePath, const void* data, uint32_t data_size );
+uint32_t         FlushWrites();
 void             ListFiles( string_buffer_t* s, const char* relative_path, uint32_t flags, BXIAllocator* allocator );
 
@@ -2,23 +2,111 @@
 
 #include <memory/memory.h>
 #include <foundation/debug.h>
-#include <foundation/queue.h>
 #include <foundation/io.h>
+#include <foundation/array.h>
+#include <foundation/hashmap.h>
+#include <foundation/hashed_string.h>
+#include <foundation/string_util.h>
+
+#include <algorithm>
+#include <chrono>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <winioctl.h>
+#include <io.h>
+#include <fcntl.h>
 
 namespace bx
 {
 
 // ---
 //
+struct FilePhysicalOrder
+{
+    uint64_t lcn = UINT64_MAX;
+    uint64_t file_index = UINT64_MAX;
+    BXFileHandle handle;
+    FILE* file = nullptr; // opened for read, so LoadFileInternal doesn't open it again
+};
+
+// CRT has limited number of streams (512 by default), so only this many files of batch are kept open between query and read.
+// The rest is queried with attributes only handle and opened again when read
+static constexpr uint32_t BATCH_MAX_OPEN_FILES = 128;
+inline bool operator < ( const FilePhysicalOrder& a, const FilePhysicalOrder& b )
+{
+    return (a.lcn != b.lcn) ? a.lcn < b.lcn : a.file_index < b.file_index;
+}
+
+// Logical cluster number of the first extent is the closest thing to a disk offset we can get.
+// Small files are resident in MFT and don't have extents, so they go first ordered by MFT record.
+// With 'keep_open' file is opened for reading here and handed over to LoadFileInternal, so it's opened once.
+static FilePhysicalOrder QueryPhysicalOrder( const char* absolutePath, bool keep_open )
+{
+    FilePhysicalOrder result;
+
+    const DWORD access = (keep_open) ? GENERIC_READ : FILE_READ_ATTRIBUTES;
+    HANDLE hfile = CreateFileA( absolutePath, access, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+    if( hfile == INVALID_HANDLE_VALUE )
+        return result;
+
+    BY_HANDLE_FILE_INFORMATION info = {};
+    if( GetFileInformationByHandle( hfile, &info ) )
+    {
+        result.file_index = ((uint64_t)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+    }
+
+    STARTING_VCN_INPUT_BUFFER input = {};
+    RETRIEVAL_POINTERS_BUFFER output = {};
+    DWORD nb_bytes = 0;
+    const BOOL ok = DeviceIoControl( hfile, FSCTL_GET_RETRIEVAL_POINTERS, &input, sizeof( input ), &output, sizeof( output ), &nb_bytes, NULL );
+    if( (ok || GetLastError() == ERROR_MORE_DATA) && output.ExtentCount > 0 )
+    {
+        result.lcn = (uint64_t)output.Extents[0].Lcn.QuadPart;
+    }
+    else
+    {
+        result.lcn = 0;
+    }
+
+    if( !keep_open )
+    {
+        CloseHandle( hfile );
+        return result;
+    }
+
+    // CRT takes ownership of handle, fclose closes it
+    const int fd = _open_osfhandle( (intptr_t)hfile, _O_RDONLY | _O_BINARY );
+    if( fd != -1 )
+    {
+        result.file = _fdopen( fd, "rb" );
+        if( !result.file )
+            _close( fd );
+    }
+    else
+    {
+        CloseHandle( hfile );
+    }
+    return result;
+}
 
 
 // ---
 //
 FilesystemWindows::FilesystemWindows( BXIAllocator* allocator )
-	: _to_load( allocator )
-	, _to_unload( allocator )
+	: _to_write( allocator )
+	, _to_write_lookup( allocator )
+	, _changes( allocator )
 	, _allocator( allocator )
 {
+	// handle can be closed and reused while it's still queued, so load ring has some slack over MAX_HANDLES
+	_to_load.create( MAX_HANDLES * 2, allocator );
+	_to_unload.create( MAX_HANDLES, allocator );
 }
 bool FilesystemWindows::Startup()
 {
@@ -29,6 +117,9 @@ bool FilesystemWindows::Startup()
 }
 void FilesystemWindows::Shutdown()
 {
+	WatchChanges( false );
+	FlushWrites();
+
 	_is_running = 0;
 	_semaphore.signal();
 	_thread.join();
@@ -51,6 +142,24 @@ bool FilesystemWindows::IsValid( BXFileHandle fhandle )
 	return id_table::has( _ids, id );
 }
 
+BXFileHandle FilesystemWindows::InitInputInfo( id_t id, const char* relativePath, BXEFIleMode::E mode, BXPostLoadCallback callback, BXIAllocator* allocator )
+{
+	_files_status[id.index].store( BXEFileStatus::LOADING );
+
+	FileInputInfo& info = _input_info[id.index];
+	info._mode = mode;
+	info._name.Clear();
+	info._name.AppendRelativePath( relativePath );
+    info._callback = callback;
+	info._allocator = allocator;
+	info._chunk_callback = {};
+	info._chunk_size = 0;
+
+	BXFileHandle fhandle;
+	fhandle.i = id.hash;
+	return fhandle;
+}
+
 BXFileHandle FilesystemWindows::LoadFile( const char* relativePath, BXEFIleMode::E mode, BXPostLoadCallback callback, BXIAllocator* allocator )
 {
 	if( !allocator )
@@ -62,24 +171,75 @@ BXFileHandle FilesystemWindows::LoadFile( const char* relativePath, BXEFIleMode:
 	id = id_table::create( _ids );
 	_id_lock.unlock();
 
-	_files_status[id.index].store( BXEFileStatus::LOADING );
+	BXFileHandle fhandle = InitInputInfo( id, relativePath, mode, callback, allocator );
+
+	PushToLoad( fhandle );
+
+	return fhandle;
+}
+
+BXFileHandle FilesystemWindows::StreamFile( const char* relativePath, uint32_t chunk_size, BXStreamChunkCallback chunk_callback, BXPostLoadCallback callback, BXIAllocator* allocator )
+{
+	SYS_ASSERT( chunk_size > 0 );
+	SYS_ASSERT( chunk_callback.callback != nullptr );
+
+	if( !allocator )
+		allocator = _allocator;
+
+	id_t id = { 0 };
+
+	_id_lock.lock();
+	id = id_table::create( _ids );
+	_id_lock.unlock();
 
+	BXFileHandle fhandle = InitInputInfo( id, relativePath, BXEFIleMode::STREAM, callback, allocator );
 	FileInputInfo& info = _input_info[id.index];
-	info._mode = mode;
-	info._name.Clear();
-	info._name.AppendRelativePath( relativePath );
-    info._callback = callback;
-	info._allocator = allocator;
+	info._chunk_callback = chunk_callback;
+	info._chunk_size = chunk_size;
 
-	BXFileHandle fhandle;
-	fhandle.i = id.hash;
+	PushToLoad( fhandle );
+
+	return fhandle;
+}
+
+bool FilesystemWindows::LoadFiles( BXFileHandle* out_handles, const char* const* relativePaths, uint32_t count, BXEFIleMode::E mode, BXPostLoadBatchCallback callback, BXIAllocator* allocator )
+{
+	if( !count )
+		return false;
+
+	if( !allocator )
+		allocator = _allocator;
 
-	_to_load_lock.lock();
-	queue::push_back( _to_load, fhandle );
-	_to_load_lock.unlock();
+	const uint32_t mem_size = sizeof( FileBatchInfo ) + (count - 1) * sizeof( BXFileHandle );
+	FileBatchInfo* batch = (FileBatchInfo*)BX_MALLOC( _allocator, mem_size, ALIGNOF( FileBatchInfo ) );
+	batch->_callback = callback;
+	batch->_count = count;
+
+	_id_lock.lock();
+	if( id_table::size( _ids ) + count > MAX_HANDLES )
+	{
+		_id_lock.unlock();
+		BX_FREE( _allocator, batch );
+		SYS_LOG_ERROR( "Filesystem: batch of %u files exceeds available handles", count );
+		return false;
+	}
+	for( uint32_t i = 0; i < count; ++i )
+	{
+		const id_t id = id_table::create( _ids );
+		batch->_handles[i].i = id.hash;
+	}
+	_id_lock.unlock();
+
+	for( uint32_t i = 0; i < count; ++i )
+	{
+		const id_t id = { batch->_handles[i].i };
+		out_handles[i] = InitInputInfo( id, relativePaths[i], mode, BXPostLoadCallback{}, allocator );
+	}
+
+	_to_load_batch.push( &batch->_node );
 	_semaphore.signal();
 
-	return fhandle;
+	return true;
 }
 
 void FilesystemWindows::CloseFile( BXFileHandle* fhandle, bool freeData )
@@ -98,10 +258,15 @@ void FilesystemWindows::CloseFile( BXFileHandle* fhandle, bool freeData )
 
 	if( freeData )
 	{
-		_to_unload_lock.lock();
-		queue::push_back( _to_unload, file );
-		_to_unload_lock.unlock();
-		_semaphore.signal();
+		if( _to_unload.push( file ) )
+		{
+			_semaphore.signal();
+		}
+		else
+		{
+			// io thread is behind, so data is freed here instead of waiting for space
+			BX_FREE( file.allocator, file.pointer );
+		}
 	}
 
     _files[id.index] = {};
@@ -122,24 +287,517 @@ BXEFileStatus::E FilesystemWindows::File( BXFile* file, BXFileHandle fhandle )
 	return status;
 }
 
+void FilesystemWindows::WriteFileAsync( const char* relativePath, const void* data, uint32_t data_size )
+{
+	void* data_copy = BX_MALLOC( _allocator, data_size, 16 );
+	memcpy( data_copy, data, data_size );
+
+	FileWriteInfo info;
+	info._name.AppendRelativePath( relativePath );
+	info._name_hash = hashed_string( info._name.AbsolutePath() );
+	info._data = data_copy;
+	info._size = data_size;
+
+	void* data_to_free = nullptr;
+	{
+		std::lock_guard<std::mutex> guard( _to_write_lock );
+		_writes_issued += 1;
+
+		const uint32_t pending_index = hash::get( _to_write_lookup, info._name_hash, UINT32_MAX );
+		if( pending_index != UINT32_MAX )
+		{
+			// not written yet, so previous data is simply replaced
+			FileWriteInfo& pending = _to_write[pending_index];
+			data_to_free = pending._data;
+			pending._data = info._data;
+			pending._size = info._size;
+			_writes_done += 1;
+		}
+		else
+		{
+			hash::set( _to_write_lookup, info._name_hash, array::size( _to_write ) );
+			array::push_back( _to_write, info );
+		}
+	}
+
+	BX_FREE( _allocator, data_to_free );
+	_semaphore.signal();
+}
+
+uint32_t FilesystemWindows::FlushWrites()
+{
+	uint64_t target = 0;
+	{
+		std::lock_guard<std::mutex> guard( _to_write_lock );
+		target = _writes_issued;
+	}
+
+	std::unique_lock<std::mutex> guard( _wait_lock );
+	_wait_cv.wait( guard, [this, target]() { return _writes_done.load() >= target; } );
+
+	return _writes_failed.exchange( 0 );
+}
+
+void FilesystemWindows::WriteFileInternal( const FileWriteInfo& info )
+{
+	FSName path;
+	path.Append( _root.AbsolutePath() );
+
+	FSName tmp_path;
+	tmp_path.Append( _root.AbsolutePath() );
+
+	bool ok = path.AppendRelativePath( info._name.AbsolutePath() );
+	ok = ok && tmp_path.AppendRelativePath( info._name.AbsolutePath() );
+	ok = ok && tmp_path.Append( ".tmp" );
+	if( !ok )
+	{
+		SYS_LOG_ERROR( "Filesystem: path '%s' is to long", info._name.AbsolutePath() );
+	}
+	else
+	{
+		ok = WriteFile( tmp_path.AbsolutePath(), info._data, info._size ) == (int)info._size;
+		ok = ok && MoveFileExA( tmp_path.AbsolutePath(), path.AbsolutePath(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH );
+		if( !ok )
+		{
+			SYS_LOG_ERROR( "Filesystem: can not write file '%s'", path.AbsolutePath() );
+			DeleteFileA( tmp_path.AbsolutePath() );
+		}
+	}
+
+	if( !ok )
+	{
+		_writes_failed += 1;
+	}
+}
+
+bool FilesystemWindows::IsDone( BXFileHandle fhandle )
+{
+	if( !IsValid( fhandle ) )
+		return true;
+
+	const id_t id = { fhandle.i };
+	return _files_status[id.index].load() != BXEFileStatus::LOADING;
+}
+
+void FilesystemWindows::NotifyWaiters()
+{
+	// empty critical section makes sure waiter is either before predicate check or already sleeping
+	{
+		std::lock_guard<std::mutex> guard( _wait_lock );
+	}
+	_wait_cv.notify_all();
+}
+
+template< typename Tpred >
+static bool WaitForCondition( std::mutex& lock, std::condition_variable& cv, uint32_t timeout_ms, Tpred pred )
+{
+	if( pred() )
+		return true;
+
+	std::unique_lock<std::mutex> guard( lock );
+	if( timeout_ms == BX_FILE_WAIT_INFINITE )
+	{
+		cv.wait( guard, pred );
+		return true;
+	}
+	return cv.wait_for( guard, std::chrono::milliseconds( timeout_ms ), pred );
+}
+
+BXEFileStatus::E FilesystemWindows::Wait( BXFileHandle fhandle, uint32_t timeout_ms )
+{
+	WaitForCondition( _wait_lock, _wait_cv, timeout_ms, [this, fhandle]() { return IsDone( fhandle ); } );
+
+	BXFile file;
+	return File( &file, fhandle );
+}
+
+bool FilesystemWindows::WaitAll( const BXFileHandle* fhandles, uint32_t count, uint32_t timeout_ms )
+{
+	uint32_t nb_done = 0;
+	return WaitForCondition( _wait_lock, _wait_cv, timeout_ms, [this, fhandles, count, &nb_done]()
+	{
+		// handles never go back to LOADING, so already finished prefix doesn't have to be checked again
+		while( nb_done < count && IsDone( fhandles[nb_done] ) )
+			++nb_done;
+
+		return nb_done == count;
+	} );
+}
+
+uint32_t FilesystemWindows::WaitAny( const BXFileHandle* fhandles, uint32_t count, uint32_t timeout_ms )
+{
+	uint32_t found = BX_FILE_WAIT_TIMEOUT;
+	WaitForCondition( _wait_lock, _wait_cv, timeout_ms, [this, fhandles, count, &found]()
+	{
+		for( uint32_t i = 0; i < count; ++i )
+		{
+			if( IsDone( fhandles[i] ) )
+			{
+				found = i;
+				return true;
+			}
+		}
+		return false;
+	} );
+	return found;
+}
+
+// change has to be older than this to be reported. Editors often write file in several steps
+static constexpr uint64_t FILE_CHANGE_SETTLE_MS = 200;
+
+bool FilesystemWindows::WatchChanges( bool enable )
+{
+	if( enable == (_watch_stop_event != nullptr) )
+		return true;
+
+	if( enable )
+	{
+		_watch_stop_event = CreateEventA( NULL, TRUE, FALSE, NULL );
+		_watch_thread = std::thread( [this]() { WatchProc(); } );
+	}
+	else
+	{
+		SetEvent( (HANDLE)_watch_stop_event );
+		_watch_thread.join();
+		CloseHandle( (HANDLE)_watch_stop_event );
+		_watch_stop_event = nullptr;
+
+		std::lock_guard<std::mutex> guard( _changes_lock );
+		array::clear( _changes );
+	}
+	return true;
+}
+
+uint32_t FilesystemWindows::PollChanges( string_buffer_t* s )
+{
+	const uint64_t now = GetTickCount64();
+	uint32_t count = 0;
+
+	std::lock_guard<std::mutex> guard( _changes_lock );
+	for( int32_t i = (int32_t)array::size( _changes ) - 1; i >= 0; --i )
+	{
+		const FileChangeInfo& info = _changes[i];
+		if( now - info._time_ms < FILE_CHANGE_SETTLE_MS )
+			continue;
+
+		string::append( s, info._name.RelativePath() );
+		array::erase_swap( _changes, i );
+		++count;
+	}
+	return count;
+}
+
+void FilesystemWindows::WatchProc()
+{
+	HANDLE hdir = CreateFileA( _root.AbsolutePath(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL );
+	if( hdir == INVALID_HANDLE_VALUE )
+	{
+		SYS_LOG_ERROR( "Can not watch directory '%s'", _root.AbsolutePath() );
+		return;
+	}
+
+	constexpr DWORD BUFFER_SIZE = 64 * 1024;
+	uint8_t* buffer = (uint8_t*)BX_MALLOC( _allocator, BUFFER_SIZE, sizeof( DWORD ) );
+
+	OVERLAPPED overlapped = {};
+	overlapped.hEvent = CreateEventA( NULL, FALSE, FALSE, NULL );
+
+	const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+	const HANDLE events[2] = { overlapped.hEvent, (HANDLE)_watch_stop_event };
+
+	while( ReadDirectoryChangesW( hdir, buffer, BUFFER_SIZE, TRUE, filter, NULL, &overlapped, NULL ) )
+	{
+		DWORD nb_bytes = 0;
+		if( WaitForMultipleObjects( 2, events, FALSE, INFINITE ) != WAIT_OBJECT_0 )
+		{
+			CancelIo( hdir );
+			GetOverlappedResult( hdir, &overlapped, &nb_bytes, TRUE );
+			break;
+		}
+
+		if( !GetOverlappedResult( hdir, &overlapped, &nb_bytes, FALSE ) )
+			break;
+		
+		if( nb_bytes == 0 )
+		{
+			SYS_LOG_WARNING( "Too many changes in '%s'. Some were lost", _root.AbsolutePath() );
+			continue;
+		}
+
+		const uint64_t now = GetTickCount64();
+		const uint8_t* current = buffer;
+		for( ;; )
+		{
+			const FILE_NOTIFY_INFORMATION* notify = (const FILE_NOTIFY_INFORMATION*)current;
+			const bool interesting = notify->Action == FILE_ACTION_ADDED || notify->Action == FILE_ACTION_MODIFIED || notify->Action == FILE_ACTION_RENAMED_NEW_NAME;
+			
+			char relative_path[FSName::MAX_LENGTH + 1] = {};
+			const int len = (interesting) ? WideCharToMultiByte( CP_UTF8, 0, notify->FileName, notify->FileNameLength / sizeof( WCHAR ), relative_path, FSName::MAX_LENGTH, NULL, NULL ) : 0;
+			if( len > 0 )
+			{
+				for( int i = 0; i < len; ++i )
+				{
+					if( relative_path[i] == '\\' )
+						relative_path[i] = '/';
+				}
+
+				FileChangeInfo info;
+				info._name.AppendRelativePath( relative_path );
+				info._name_hash = hashed_string( relative_path );
+				info._time_ms = now;
+
+				std::lock_guard<std::mutex> guard( _changes_lock );
+				bool found = false;
+				for( FileChangeInfo& change : _changes )
+				{
+					if( change._name_hash == info._name_hash )
+					{
+						change._time_ms = now;
+						found = true;
+						break;
+					}
+				}
+				if( !found )
+				{
+					array::push_back( _changes, info );
+				}
+			}
+
+			if( notify->NextEntryOffset == 0 )
+				break;
+			current += notify->NextEntryOffset;
+		}
+	}
+
+	CloseHandle( overlapped.hEvent );
+	CloseHandle( hdir );
+	BX_FREE( _allocator, buffer );
+}
+
 void FilesystemWindows::ThreadProcStatic( FilesystemWindows* fs )
 {
 	fs->ThreadProc();
 }
 
-template< typename T>
-static inline bool PopFromQueueSafe( T* fhandle, queue_t<T>& queue, std::mutex& lock )
+namespace
+{
+	struct StreamContext
+	{
+		FilesystemWindows* fs;
+		BXFileHandle fhandle;
+		const BXStreamChunkCallback* cb;
+	};
+
+	// Double buffered: read of next chunk is issued (overlapped) before callback parses current one, so parsing overlaps I/O.
+	// Callback still runs on io thread, so slow callback delays other files. Contract is the same as ReadFileChunked
+	static int32_t ReadFileChunkedOverlapped( const char* path, uint32_t chunk_size, ReadFileChunkCallback* callback, void* user_data, BXIAllocator* allocator )
+	{
+		SYS_ASSERT( chunk_size > 0 );
+
+		HANDLE hfile = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+		if( hfile == INVALID_HANDLE_VALUE )
+			return IO_ERROR;
+
+		LARGE_INTEGER file_size = {};
+		if( !GetFileSizeEx( hfile, &file_size ) || file_size.QuadPart > UINT32_MAX )
+		{
+			CloseHandle( hfile );
+			return IO_ERROR;
+		}
+		const uint32_t total_size = (uint32_t)file_size.QuadPart;
+
+		if( total_size == 0 )
+		{
+			CloseHandle( hfile );
+			return ( callback( nullptr, 0, 0, 0, user_data ) ) ? IO_OK : IO_ERROR;
+		}
+
+		uint8_t* buf[2] = {};
+		OVERLAPPED ov[2] = {};
+		for( uint32_t i = 0; i < 2; ++i )
+		{
+			buf[i] = (uint8_t*)BX_MALLOC( allocator, chunk_size, 16 );
+			ov[i].hEvent = CreateEventA( NULL, TRUE, FALSE, NULL );
+		}
+
+		auto issue_read = [&]( uint32_t slot, uint32_t offset ) -> bool
+		{
+			const uint32_t to_read = ( total_size - offset < chunk_size ) ? total_size - offset : chunk_size;
+			ov[slot].Offset = offset;
+			ov[slot].OffsetHigh = 0;
+			ResetEvent( ov[slot].hEvent );
+			return ::ReadFile( hfile, buf[slot], to_read, NULL, &ov[slot] ) || GetLastError() == ERROR_IO_PENDING;
+		};
+
+		int32_t result = IO_OK;
+		uint32_t current = 0;
+		uint32_t offset = 0;
+		bool next_pending = issue_read( current, 0 );
+		if( !next_pending )
+			result = IO_ERROR;
+
+		while( result == IO_OK && offset < total_size )
+		{
+			const uint32_t to_read = ( total_size - offset < chunk_size ) ? total_size - offset : chunk_size;
+			DWORD read_bytes = 0;
+			next_pending = false;
+			if( !GetOverlappedResult( hfile, &ov[current], &read_bytes, TRUE ) || read_bytes != to_read )
+			{
+				SYS_LOG_ERROR( "Can't read chunk at offset %u (size: %u)\n", offset, total_size );
+				result = IO_ERROR;
+				break;
+			}
+
+			const uint32_t next_offset = offset + to_read;
+			if( next_offset < total_size )
+			{
+				next_pending = issue_read( current ^ 1, next_offset );
+				if( !next_pending )
+				{
+					result = IO_ERROR;
+					break;
+				}
+			}
+
+			if( !callback( buf[current], to_read, offset, total_size, user_data ) )
+			{
+				result = IO_ERROR;
+				break;
+			}
+
+			offset = next_offset;
+			current ^= 1;
+		}
+
+		// buffer can't be freed while read into it is in flight
+		if( next_pending && result != IO_OK )
+		{
+			DWORD ignored = 0;
+			CancelIo( hfile );
+			GetOverlappedResult( hfile, &ov[current ^ 1], &ignored, TRUE );
+		}
+
+		for( uint32_t i = 0; i < 2; ++i )
+		{
+			CloseHandle( ov[i].hEvent );
+			BX_FREE( allocator, buf[i] );
+		}
+		CloseHandle( hfile );
+		return result;
+	}
+}
+
+bool FilesystemWindows::StreamChunkStatic( const void* chunk, unsigned chunk_size, unsigned offset, unsigned total_size, void* user_data )
 {
-	bool result = false;
-	lock.lock();
-	if( result = !queue::empty( queue ) )
+	StreamContext* ctx = (StreamContext*)user_data;
+	const BXStreamChunkCallback* cb = ctx->cb;
+	const id_t id = { ctx->fhandle.i };
+	ctx->fs->_files[id.index].size = total_size;
+	return (*cb->callback)(ctx->fs, ctx->fhandle, chunk, chunk_size, offset, total_size, cb->user_data0, cb->user_data1, cb->user_data2);
+}
+
+void FilesystemWindows::PushToLoad( BXFileHandle fhandle )
+{
+	// ring is full only when io thread is far behind. Wake it and wait for free slot
+	while( !_to_load.push( fhandle ) )
 	{
-		fhandle[0] = queue::front( queue );
-		queue::pop_front( queue );
+		_semaphore.signal();
+		std::this_thread::yield();
 	}
-	lock.unlock();
+	_semaphore.signal();
+}
+
+void FilesystemWindows::LoadFileInternal( BXFileHandle fhandle, FILE* opened )
+{
+	const id_t id = { fhandle.i };
+	const FileInputInfo& info = _input_info[id.index];
 
-	return result;
+	FSName path;
+	path.Append( _root.AbsolutePath() );
+	if( path.AppendRelativePath( info._name.AbsolutePath() ) )
+	{
+		BXFile& file = _files[id.index];
+		int32_t result = IO_ERROR;
+		
+		file.allocator = info._allocator;
+
+		if( info._mode == BXEFIleMode::BIN )
+			result = (opened) ? ReadFile( &file.bin, &file.size, opened, info._allocator ) : ReadFile( &file.bin, &file.size, path.AbsolutePath(), info._allocator );
+		else if( info._mode == BXEFIleMode::TXT )
+			result = (opened) ? ReadTextFile( &file.bin, &file.size, opened, info._allocator ) : ReadTextFile( &file.bin, &file.size, path.AbsolutePath(), info._allocator );
+		else if( info._mode == BXEFIleMode::STREAM )
+		{
+			StreamContext ctx = { this, fhandle, &info._chunk_callback };
+			// overlapped reads need handle opened for it, so file opened by batch query is not used
+			if( opened )
+				fclose( opened );
+			result = ReadFileChunkedOverlapped( path.AbsolutePath(), info._chunk_size, StreamChunkStatic, &ctx, info._allocator );
+			file.pointer = nullptr;
+			file.allocator = nullptr;
+		}
+		else if( opened )
+		{
+			fclose( opened );
+		}
+
+		const BXEFileStatus::E file_status = (result == IO_OK) ? BXEFileStatus::READY : BXEFileStatus::NOT_FOUND;
+		_files_status[id.index].store( file_status );
+		NotifyWaiters();
+        if( info._callback.callback )
+        {
+            (*info._callback.callback)(this, fhandle, file_status, info._callback.user_data0, info._callback.user_data1, info._callback.user_data2 );
+        }
+	}
+	else
+	{
+		SYS_LOG_ERROR( "Filesystem: path '%s' is to long", info._name.AbsolutePath() );
+		if( opened )
+			fclose( opened );
+		CloseFile( &fhandle, false );
+		NotifyWaiters();
+	}
+}
+
+void FilesystemWindows::LoadBatchInternal( FileBatchInfo* batch )
+{
+	const uint32_t count = batch->_count;
+	FilePhysicalOrder* order = (FilePhysicalOrder*)BX_MALLOC( _allocator, count * sizeof( FilePhysicalOrder ), ALIGNOF( FilePhysicalOrder ) );
+	
+	for( uint32_t i = 0; i < count; ++i )
+	{
+		const BXFileHandle fhandle = batch->_handles[i];
+		const id_t id = { fhandle.i };
+		
+		FSName path;
+		path.Append( _root.AbsolutePath() );
+		if( path.AppendRelativePath( _input_info[id.index]._name.AbsolutePath() ) )
+		{
+			order[i] = QueryPhysicalOrder( path.AbsolutePath(), i < BATCH_MAX_OPEN_FILES );
+		}
+		else
+		{
+			// goes last, LoadFileInternal reports it
+			order[i] = FilePhysicalOrder();
+		}
+		order[i].handle = fhandle;
+	}
+
+	std::sort( order, order + count );
+
+	for( uint32_t i = 0; i < count; ++i )
+	{
+		LoadFileInternal( order[i].handle, order[i].file );
+	}
+
+	BX_FREE( _allocator, order );
+
+	const BXPostLoadBatchCallback& cb = batch->_callback;
+	if( cb.callback )
+	{
+		(*cb.callback)(this, batch->_handles, count, cb.user_data0, cb.user_data1, cb.user_data2);
+	}
+
+	BX_FREE( _allocator, batch );
 }
 
 void FilesystemWindows::ThreadProc()
@@ -152,45 +810,45 @@ void FilesystemWindows::ThreadProc()
 		while( true )
 		{
 			BXFileHandle fhandle = {};
-			if( !PopFromQueueSafe( &fhandle, _to_load, _to_load_lock ) )
+			if( !_to_load.pop( &fhandle ) )
 				break;
 				
-			const id_t id = { fhandle.i };
-			const FileInputInfo& info = _input_info[id.index];
+			LoadFileInternal( fhandle );
+		}
 
-			FSName path;
-			path.Append( _root.AbsolutePath() );
-			if( path.AppendRelativePath( info._name.AbsolutePath() ) )
-			{
-				BXFile& file = _files[id.index];
-				int32_t result = IO_ERROR;
-				
-				file.allocator = info._allocator;
-
-				if( info._mode == BXEFIleMode::BIN )
-					result = ReadFile( &file.bin, &file.size, path.AbsolutePath(), info._allocator );
-				else if( info._mode == BXEFIleMode::TXT )
-					result = ReadTextFile( &file.bin, &file.size, path.AbsolutePath(), info._allocator );
-
-				const BXEFileStatus::E file_status = (result == IO_OK) ? BXEFileStatus::READY : BXEFileStatus::NOT_FOUND;
-				_files_status[id.index].store( file_status );
-                if( info._callback.callback )
-                {
-                    (*info._callback.callback)(this, fhandle, file_status, info._callback.user_data0, info._callback.user_data1, info._callback.user_data2 );
-                }
-			}
-			else
-			{
-				SYS_LOG_ERROR( "Filesystem: path '%s' is to long", info._name.AbsolutePath() );
-				CloseFile( &fhandle, false );
-			}
+		// load batches
+		while( true )
+		{
+			FileBatchInfo* batch = (FileBatchInfo*)_to_load_batch.pop();
+			if( !batch )
+				break;
+
+			LoadBatchInternal( batch );
+		}
+
+		// write files
+		array_t<FileWriteInfo> to_write( _allocator );
+		{
+			std::lock_guard<std::mutex> guard( _to_write_lock );
+			to_write = std::move( _to_write );
+			hash::clear( _to_write_lookup );
+		}
+		for( const FileWriteInfo& info : to_write )
+		{
+			WriteFileInternal( info );
+			BX_FREE( _allocator, info._data );
+			_writes_done += 1;
+		}
+		if( array::any( to_write ) )
+		{
+			NotifyWaiters();
 		}
 
 		// close files
 		while( true )
 		{
 			BXFile file = {};
-			if( !PopFromQueueSafe( &file, _to_unload, _to_unload_lock ) )
+			if( !_to_unload.pop( &file ) )
 				break;
 
 			BX_FREE( file.allocator, file.pointer );
@@ -200,4 +858,3 @@ void FilesystemWindows::ThreadProc()
 }
 
 }//
-
@@ -5,10 +5,13 @@
 #include "../foundation/debug.h"
 #include "../foundation/id_table.h"
 #include "../foundation/thread/semaphore.h"
+#include "../foundation/thread/lockfree_queue.h"
 #include "../util/file_system_name.h"
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
+#include <stdio.h>
 
 
 namespace bx
@@ -19,8 +22,33 @@ namespace bx
 		BXEFIleMode::E _mode;
         BXPostLoadCallback _callback;
         BXIAllocator* _allocator;
+        BXStreamChunkCallback _chunk_callback;
+        uint32_t _chunk_size;
 	};
 
+    struct FileWriteInfo
+    {
+        FSName _name;
+        uint64_t _name_hash;
+        void* _data;
+        uint32_t _size;
+    };
+
+    struct FileChangeInfo
+    {
+        FSName _name;
+        uint64_t _name_hash;
+        uint64_t _time_ms;
+    };
+
+    struct FileBatchInfo
+    {
+        mpsc_node_t _node; // has to be first
+        BXPostLoadBatchCallback _callback;
+        uint32_t _count;
+        BXFileHandle _handles[1];
+    };
+
 struct FilesystemWindows : BXIFilesystem
 {
 	FilesystemWindows( BXIAllocator* allocator );
@@ -32,14 +60,32 @@ struct FilesystemWindows : BXIFilesystem
 	void			 SetRoot( const char* absoluteDirPath ) override final;
     const char*      GetRoot() const override;
 	BXFileHandle	 LoadFile( const char* relativePath, BXEFIleMode::E mode, BXPostLoadCallback callback, BXIAllocator* allocator = nullptr ) override final;
+    BXFileHandle     StreamFile( const char* relativePath, uint32_t chunk_size, BXStreamChunkCallback chunk_callback, BXPostLoadCallback callback, BXIAllocator* allocator = nullptr ) override final;
+    bool             LoadFiles( BXFileHandle* out_handles, const char* const* relativePaths, uint32_t count, BXEFIleMode::E mode, BXPostLoadBatchCallback callback, BXIAllocator* allocator = nullptr ) override final;
 	void			 CloseFile( BXFileHandle* fhandle, bool freeData ) override final;
 	BXEFileStatus::E File( BXFile* file, BXFileHandle fhandle ) override final;
+	void             WriteFileAsync( const char* relativePath, const void* data, uint32_t data_size ) override final;
+	uint32_t         FlushWrites() override final;
+	BXEFileStatus::E Wait( BXFileHandle fhandle, uint32_t timeout_ms = BX_FILE_WAIT_INFINITE ) override final;
+	bool             WaitAll( const BXFileHandle* fhandles, uint32_t count, uint32_t timeout_ms = BX_FILE_WAIT_INFINITE ) override final;
+	uint32_t         WaitAny( const BXFileHandle* fhandles, uint32_t count, uint32_t timeout_ms = BX_FILE_WAIT_INFINITE ) override final;
+	bool             WatchChanges( bool enable ) override final;
+	uint32_t         PollChanges( string_buffer_t* s ) override final;
 
 	// ---
 	static void ThreadProcStatic( FilesystemWindows* fs );
+    static bool StreamChunkStatic( const void* chunk, unsigned chunk_size, unsigned offset, unsigned total_size, void* user_data );
 	void ThreadProc();
+	void WatchProc();
 
 	// ---
+    BXFileHandle InitInputInfo( id_t id, const char* relativePath, BXEFIleMode::E mode, BXPostLoadCallback callback, BXIAllocator* allocator );
+    void         PushToLoad( BXFileHandle fhandle );
+    void         LoadFileInternal( BXFileHandle fhandle, FILE* opened = nullptr ); // takes ownership of 'opened'
+    void         LoadBatchInternal( FileBatchInfo* batch );
+    void         WriteFileInternal( const FileWriteInfo& info );
+    bool         IsDone( BXFileHandle fhandle );
+    void         NotifyWaiters();
 
 	// --- data
 	enum
@@ -60,11 +106,25 @@ struct FilesystemWindows : BXIFilesystem
 	BXFile				_files       [MAX_HANDLES] = {};
 	std::atomic_int32_t _files_status[MAX_HANDLES] = {};
 
-	queue_t<BXFileHandle>  _to_load;
-	queue_t<BXFile>		   _to_unload;
+	// filled from any thread, drained by io thread only
+	mpmc_queue_t<BXFileHandle> _to_load;
+	mpsc_queue_t               _to_load_batch;
+	mpmc_queue_t<BXFile>       _to_unload;
+
+	array_t<FileWriteInfo> _to_write;
+	hash_t<uint32_t>       _to_write_lookup;
+	std::mutex             _to_write_lock;
+	uint64_t               _writes_issued = 0;
+	std::atomic_uint64_t   _writes_done = 0;
+	std::atomic_uint32_t   _writes_failed = 0;
+
+	std::mutex              _wait_lock;
+	std::condition_variable _wait_cv;
 
-	std::mutex _to_load_lock;
-	std::mutex _to_unload_lock;
+	std::thread             _watch_thread;
+	void*                   _watch_stop_event = nullptr;
+	array_t<FileChangeInfo> _changes;
+	std::mutex              _changes_lock;
 
 	FSName		  _root;
 	BXIAllocator* _allocator = nullptr;
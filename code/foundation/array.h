@@ -55,6 +55,20 @@ namespace array
         return (int)( arr.size++ );
     }
 
+    // constructs element in place. array_t still moves elements with memcpy, so T has to be trivially relocatable
+    template< typename T, typename... Targs > T& emplace_back( array_t<T>& arr, Targs&&... args )
+    {
+        if( arr.size + 1 > arr.capacity )
+        {
+            const uint32_t new_capacity = (arr.capacity) ? arr.capacity * 2 : 8;
+            array_internal::_Grow( arr, new_capacity );
+        }
+
+        T* item = new( arr.data + arr.size ) T( std::forward<Targs>( args )... );
+        arr.size++;
+        return *item;
+    }
+
     template< typename T > void pop_back( array_t<T>& arr )
     {
         arr.size = ( arr.size > 0 ) ? --arr.size : 0;
@@ -100,6 +114,12 @@ namespace array
         arr.size = newSize;
     }
 
+    // the same as resize (array_t never initializes elements), but says so at call site
+    template< typename T > void resize_uninitialized( array_t<T>& arr, uint32_t newSize )
+    {
+        resize( arr, (int)newSize );
+    }
+
     static constexpr uint32_t npos = UINT32_MAX;
 
     template< typename T > uint32_t find( const array_t<T>& arr, const T& to_find, uint32_t start_index = 0 )
@@ -1,7 +1,166 @@
 #pragma once
 
 #include "containers.h"
+#include <string.h>
+
+#if defined( _MSC_VER )
 #include <intrin.h>
+#endif
+
+#if defined( __AVX2__ )
+#define BX_BITSET_AVX2 1
+#define BX_BITSET_SSE2 1
+#include <immintrin.h>
+#elif defined( _M_X64 ) || defined( _M_AMD64 ) || defined( __SSE2__ )
+#define BX_BITSET_AVX2 0
+#define BX_BITSET_SSE2 1
+#include <emmintrin.h>
+#else
+#define BX_BITSET_AVX2 0
+#define BX_BITSET_SSE2 0
+#endif
+
+// Operations on raw arrays of 64 bit words. Shared by bitset_t and hbitset_t.
+// Bulk operations use AVX2 when compiled with /arch:AVX2, SSE2 otherwise (always available on x64).
+namespace bitset_words
+{
+    // 'w' can't be 0
+    inline uint32_t lowest_bit( uint64_t w )
+    {
+#if defined( _MSC_VER ) && defined( _M_X64 )
+        unsigned long index;
+        _BitScanForward64( &index, w );
+        return (uint32_t)index;
+#elif defined( _MSC_VER )
+        unsigned long index;
+        if( _BitScanForward( &index, (uint32_t)w ) )
+            return (uint32_t)index;
+        _BitScanForward( &index, (uint32_t)(w >> 32) );
+        return (uint32_t)index + 32;
+#else
+        return (uint32_t)__builtin_ctzll( w );
+#endif
+    }
+
+    inline uint32_t population( uint64_t w )
+    {
+#if defined( _MSC_VER ) && defined( _M_X64 )
+        return (uint32_t)__popcnt64( w );
+#elif defined( _MSC_VER )
+        return __popcnt( (uint32_t)w ) + __popcnt( (uint32_t)(w >> 32) );
+#else
+        return (uint32_t)__builtin_popcountll( w );
+#endif
+    }
+
+    namespace _internal
+    {
+        struct op_and_t
+        {
+#if BX_BITSET_AVX2
+            static __m256i vec( __m256i a, __m256i b ) { return _mm256_and_si256( a, b ); }
+#elif BX_BITSET_SSE2
+            static __m128i vec( __m128i a, __m128i b ) { return _mm_and_si128( a, b ); }
+#endif
+            static uint64_t scalar( uint64_t a, uint64_t b ) { return a & b; }
+        };
+        struct op_or_t
+        {
+#if BX_BITSET_AVX2
+            static __m256i vec( __m256i a, __m256i b ) { return _mm256_or_si256( a, b ); }
+#elif BX_BITSET_SSE2
+            static __m128i vec( __m128i a, __m128i b ) { return _mm_or_si128( a, b ); }
+#endif
+            static uint64_t scalar( uint64_t a, uint64_t b ) { return a | b; }
+        };
+        struct op_andnot_t // a & ~b
+        {
+#if BX_BITSET_AVX2
+            static __m256i vec( __m256i a, __m256i b ) { return _mm256_andnot_si256( b, a ); }
+#elif BX_BITSET_SSE2
+            static __m128i vec( __m128i a, __m128i b ) { return _mm_andnot_si128( b, a ); }
+#endif
+            static uint64_t scalar( uint64_t a, uint64_t b ) { return a & ~b; }
+        };
+
+        template< typename Top >
+        inline void binary_op( uint64_t* dst, const uint64_t* a, const uint64_t* b, uint32_t count )
+        {
+            uint32_t i = 0;
+#if BX_BITSET_AVX2
+            for( ; i + 4 <= count; i += 4 )
+            {
+                const __m256i va = _mm256_loadu_si256( (const __m256i*)(a + i) );
+                const __m256i vb = _mm256_loadu_si256( (const __m256i*)(b + i) );
+                _mm256_storeu_si256( (__m256i*)(dst + i), Top::vec( va, vb ) );
+            }
+#elif BX_BITSET_SSE2
+            for( ; i + 2 <= count; i += 2 )
+            {
+                const __m128i va = _mm_loadu_si128( (const __m128i*)(a + i) );
+                const __m128i vb = _mm_loadu_si128( (const __m128i*)(b + i) );
+                _mm_storeu_si128( (__m128i*)(dst + i), Top::vec( va, vb ) );
+            }
+#endif
+            for( ; i < count; ++i )
+                dst[i] = Top::scalar( a[i], b[i] );
+        }
+    }//
+
+    // 'dst' can be the same as 'a' or 'b'
+    inline void op_and   ( uint64_t* dst, const uint64_t* a, const uint64_t* b, uint32_t count ) { _internal::binary_op<_internal::op_and_t>( dst, a, b, count ); }
+    inline void op_or    ( uint64_t* dst, const uint64_t* a, const uint64_t* b, uint32_t count ) { _internal::binary_op<_internal::op_or_t>( dst, a, b, count ); }
+    inline void op_andnot( uint64_t* dst, const uint64_t* a, const uint64_t* b, uint32_t count ) { _internal::binary_op<_internal::op_andnot_t>( dst, a, b, count ); }
+
+    inline uint32_t population( const uint64_t* words, uint32_t count )
+    {
+        uint32_t i = 0;
+        uint64_t result = 0;
+#if BX_BITSET_AVX2
+        // nibble lookup with pshufb, bytes summed with sad (W. Mula)
+        const __m256i lookup = _mm256_setr_epi8(
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 );
+        const __m256i low_mask = _mm256_set1_epi8( 0x0f );
+        __m256i acc = _mm256_setzero_si256();
+        for( ; i + 4 <= count; i += 4 )
+        {
+            const __m256i v = _mm256_loadu_si256( (const __m256i*)(words + i) );
+            const __m256i lo = _mm256_and_si256( v, low_mask );
+            const __m256i hi = _mm256_and_si256( _mm256_srli_epi16( v, 4 ), low_mask );
+            const __m256i cnt = _mm256_add_epi8( _mm256_shuffle_epi8( lookup, lo ), _mm256_shuffle_epi8( lookup, hi ) );
+            acc = _mm256_add_epi64( acc, _mm256_sad_epu8( cnt, _mm256_setzero_si256() ) );
+        }
+        result += (uint64_t)_mm256_extract_epi64( acc, 0 ) + (uint64_t)_mm256_extract_epi64( acc, 1 )
+                + (uint64_t)_mm256_extract_epi64( acc, 2 ) + (uint64_t)_mm256_extract_epi64( acc, 3 );
+#endif
+        for( ; i < count; ++i )
+            result += population( words[i] );
+
+        return (uint32_t)result;
+    }
+
+    // calls 'func( bit_index )' for every set bit. Empty words cost one compare
+    template< typename Tfunc >
+    inline void for_each_set( const uint64_t* words, uint32_t count, Tfunc func )
+    {
+        for( uint32_t i = 0; i < count; ++i )
+        {
+            uint64_t w = words[i];
+            while( w )
+            {
+                func( i * 64 + lowest_bit( w ) );
+                w &= w - 1;
+            }
+        }
+    }
+
+    // mask of bits in word 'w' which are below 'nb_bits'
+    inline uint64_t valid_mask( uint32_t nb_bits, uint32_t w )
+    {
+        return ((w + 1) * 64 <= nb_bits) ? ~0ull : (1ull << (nb_bits & 63)) - 1;
+    }
+}//
 
 namespace bitset
 {
@@ -29,35 +188,12 @@ namespace bitset
             return addr;
         }
 
-        template< typename T >
-        FORCE_INLINE uint8_t bitscan_forward( uint32_t* index, T mask ) { return 0; }
-
-        template<>
-        FORCE_INLINE uint8_t bitscan_forward<uint32_t>( uint32_t* index, uint32_t mask )
-        {
-            return _BitScanForward( (unsigned long*)index, mask );
-        }
-
-        template<>
-        FORCE_INLINE uint8_t bitscan_forward<uint64_t>( uint32_t* index, uint64_t mask )
-        {
-            return _BitScanForward64( (unsigned long*)index, mask );
-        }
-
-        template< typename T >
-        FORCE_INLINE uint32_t population( T mask ) { return 0; }
-
-        template<>
-        FORCE_INLINE uint32_t population( uint32_t mask ) { return __popcnt( mask ); }
-        template<>
-        FORCE_INLINE uint32_t population( uint64_t mask ) { return (uint32_t)__popcnt64( mask ); }
-
     }
 
     template< BITSET_TEMPLATE_ARGS > void set_all( BITSET_T& bs )
     {
         for( uint32_t i = 0; i < bs.NUM_ELEMENTS; ++i )
-            bs.bits[i] = ~BITSET_T::type_t(0);
+            bs.bits[i] = ~(typename BITSET_T::type_t)0;
     }
 
     template< BITSET_TEMPLATE_ARGS > void clear_all( BITSET_T& bs )
@@ -68,17 +204,17 @@ namespace bitset
     template< BITSET_TEMPLATE_ARGS > void clear( BITSET_T& bs, uint32_t index )
     {
         const _internal::bit_address_t bit_addr = _internal::compute_bit_address( bs, index );
-        bs.bits[bit_addr.element] &= ~(bit_addr.mask<BITSET_T::type_t>());
+        bs.bits[bit_addr.element] &= ~(bit_addr.mask<typename BITSET_T::type_t>());
     }
     template< BITSET_TEMPLATE_ARGS > void set( BITSET_T& bs, uint32_t index )
     {
         const _internal::bit_address_t bit_addr = _internal::compute_bit_address( bs, index );
-        bs.bits[bit_addr.element] |= (bit_addr.mask<BITSET_T::type_t>());
+        bs.bits[bit_addr.element] |= (bit_addr.mask<typename BITSET_T::type_t>());
     }
     template< BITSET_TEMPLATE_ARGS > bool get( const BITSET_T& bs, uint32_t index )
     {
         const _internal::bit_address_t bit_addr = _internal::compute_bit_address( bs, index );
-        return ( bs.bits[bit_addr.element] & bit_addr.mask<BITSET_T::type_t>() ) != 0;
+        return ( bs.bits[bit_addr.element] & bit_addr.mask<typename BITSET_T::type_t>() ) != 0;
     }
 
     template< BITSET_TEMPLATE_ARGS > bool is_any_set( const BITSET_T& bs )
@@ -103,11 +239,28 @@ namespace bitset
 
     template< BITSET_TEMPLATE_ARGS > uint32_t population( const BITSET_T& bs )
     {
-        uint32_t result = 0;
-        for( uint32_t i = 0; i < BITSET_T::NUM_ELEMENTS; ++i )
-            result += _internal::population( bs.bits[i] );
+        return bitset_words::population( bs.bits, BITSET_T::NUM_ELEMENTS );
+    }
+
+    // 'dst' can be the same as 'a' or 'b'
+    template< BITSET_TEMPLATE_ARGS > void op_and( BITSET_T& dst, const BITSET_T& a, const BITSET_T& b )
+    {
+        bitset_words::op_and( dst.bits, a.bits, b.bits, BITSET_T::NUM_ELEMENTS );
+    }
+    template< BITSET_TEMPLATE_ARGS > void op_or( BITSET_T& dst, const BITSET_T& a, const BITSET_T& b )
+    {
+        bitset_words::op_or( dst.bits, a.bits, b.bits, BITSET_T::NUM_ELEMENTS );
+    }
+    // dst = a & ~b
+    template< BITSET_TEMPLATE_ARGS > void op_andnot( BITSET_T& dst, const BITSET_T& a, const BITSET_T& b )
+    {
+        bitset_words::op_andnot( dst.bits, a.bits, b.bits, BITSET_T::NUM_ELEMENTS );
+    }
 
-        return result;
+    // faster than iterator when all set bits are visited
+    template< BITSET_TEMPLATE_ARGS, typename Tfunc > void for_each_set( const BITSET_T& bs, Tfunc func )
+    {
+        bitset_words::for_each_set( bs.bits, BITSET_T::NUM_ELEMENTS, func );
     }
 
 
@@ -117,21 +270,15 @@ namespace bitset
             return SIZE;
 
         const _internal::bit_address_t bit_addr = _internal::compute_bit_address( bs, begin );
-        
-        using value_type_t = BITSET_T::type_t;
 
-        value_type_t element_index = bit_addr.element;
-        value_type_t shift = bit_addr.bit;
-        value_type_t value = bs.bits[element_index] >> shift;
+        uint32_t element_index = bit_addr.element;
+        uint64_t value = bs.bits[element_index] & (~0ull << bit_addr.bit);
         while( !value && ++element_index < BITSET_T::NUM_ELEMENTS )
         {
             value = bs.bits[element_index];
-            shift = 0;
         }
-    
-        uint32_t result = SIZE;
-        uint32_t found = _internal::bitscan_forward( &result, value );
-        return (found) ? (uint32_t)( element_index * BITSET_T::ELEMENT_BITS + (result + shift) ) : SIZE;
+
+        return (value) ? element_index * BITSET_T::ELEMENT_BITS + bitset_words::lowest_bit( value ) : SIZE;
     }
 
     template< typename Tbitset >
@@ -157,11 +304,227 @@ namespace bitset
     struct iterator : public const_iterator< Tbitset >
     {
         explicit iterator( Tbitset& bs, uint32_t begin = 0 )
-            : const_iterator( bs, begin )
+            : const_iterator< Tbitset >( bs, begin )
         {}
 
-        void set() { bitset::set( _bs, _index ); }
-        void clear() { bitset::clear( _bs, _index ); }
+        void set() { bitset::set( this->_bs, this->_index ); }
+        void clear() { bitset::clear( this->_bs, this->_index ); }
     };
 
-}
\ No newline at end of file
+}
+
+namespace hbitset
+{
+    namespace _internal
+    {
+        inline uint32_t nb_words( uint32_t nb_bits ) { return (nb_bits + 63) / 64; }
+
+        // word 'w' of 'level'. Clear bits of level 0 are inverted, so both searches look for set bit
+        inline uint64_t word( const hbitset_t& h, bool find_set, uint32_t level, uint32_t w )
+        {
+            if( level == 0 )
+                return (find_set) ? h.bits[w] : ~h.bits[w] & bitset_words::valid_mask( h.level_size[0], w );
+
+            return (find_set) ? h.any_set[level][w] : h.any_clear[level][w];
+        }
+
+        inline uint32_t find_next( const hbitset_t& h, bool find_set, uint32_t level, uint32_t begin )
+        {
+            if( begin >= h.level_size[level] )
+                return hbitset_t::INVALID;
+
+            uint32_t w = begin / 64;
+            uint64_t value = word( h, find_set, level, w ) & (~0ull << (begin & 63));
+            if( !value )
+            {
+                // top level has single word, so there is nothing more to look at
+                if( level + 1 == h.nb_levels )
+                    return hbitset_t::INVALID;
+
+                w = find_next( h, find_set, level + 1, w + 1 );
+                if( w == hbitset_t::INVALID )
+                    return hbitset_t::INVALID;
+
+                value = word( h, find_set, level, w );
+            }
+            return w * 64 + bitset_words::lowest_bit( value );
+        }
+
+        // propagates change of word 'w' in 'bits' to upper levels
+        inline void update( hbitset_t& h, uint32_t w )
+        {
+            bool has_set = h.bits[w] != 0;
+            bool has_clear = (~h.bits[w] & bitset_words::valid_mask( h.level_size[0], w )) != 0;
+            for( uint32_t level = 1; level < h.nb_levels; ++level )
+            {
+                const uint64_t mask = 1ull << (w & 63);
+                w /= 64;
+
+                uint64_t& s = h.any_set[level][w];
+                uint64_t& c = h.any_clear[level][w];
+                const uint64_t new_s = (has_set) ? s | mask : s & ~mask;
+                const uint64_t new_c = (has_clear) ? c | mask : c & ~mask;
+                if( new_s == s && new_c == c )
+                    break;
+
+                s = new_s;
+                c = new_c;
+                has_set = s != 0;
+                has_clear = c != 0;
+            }
+        }
+
+        // recomputes all upper levels from 'bits'
+        inline void rebuild( hbitset_t& h )
+        {
+            for( uint32_t level = 1; level < h.nb_levels; ++level )
+            {
+                const uint32_t count = nb_words( h.level_size[level] );
+                memset( h.any_set[level], 0x00, count * sizeof( uint64_t ) );
+                memset( h.any_clear[level], 0x00, count * sizeof( uint64_t ) );
+
+                for( uint32_t i = 0; i < h.level_size[level]; ++i )
+                {
+                    const uint64_t mask = 1ull << (i & 63);
+                    if( word( h, true, level - 1, i ) )
+                        h.any_set[level][i / 64] |= mask;
+                    if( word( h, false, level - 1, i ) )
+                        h.any_clear[level][i / 64] |= mask;
+                }
+            }
+        }
+    }//
+
+    // all bits are clear after create
+    inline void create( hbitset_t& h, uint32_t nb_bits, BXIAllocator* allocator )
+    {
+        SYS_ASSERT( nb_bits > 0 );
+        BX_FREE0( h.allocator, h.bits );
+
+        uint32_t nb_levels = 0;
+        uint32_t total_words = 0;
+        uint32_t level_bits = nb_bits;
+        for( ;; )
+        {
+            SYS_ASSERT_TXT( nb_levels < hbitset_t::MAX_LEVELS, "hbitset too big" );
+            h.level_size[nb_levels] = level_bits;
+            // upper levels are allocated twice (any_set, any_clear)
+            total_words += _internal::nb_words( level_bits ) * ((nb_levels) ? 2 : 1);
+            nb_levels++;
+            if( level_bits <= 64 )
+                break;
+
+            level_bits = _internal::nb_words( level_bits );
+        }
+
+        uint64_t* memory = (uint64_t*)BX_MALLOC( allocator, total_words * sizeof( uint64_t ), 64 );
+        memset( memory, 0x00, total_words * sizeof( uint64_t ) );
+
+        h.bits = memory;
+        memory += _internal::nb_words( nb_bits );
+        for( uint32_t level = 1; level < nb_levels; ++level )
+        {
+            const uint32_t count = _internal::nb_words( h.level_size[level] );
+            h.any_set[level] = memory;
+            h.any_clear[level] = memory + count;
+            memory += count * 2;
+        }
+        h.nb_levels = nb_levels;
+        h.allocator = allocator;
+
+        _internal::rebuild( h );
+    }
+
+    inline void destroy( hbitset_t& h )
+    {
+        BX_FREE0( h.allocator, h.bits );
+        h.nb_levels = 0;
+        h.level_size[0] = 0;
+    }
+
+    inline uint32_t size( const hbitset_t& h ) { return h.level_size[0]; }
+
+    inline bool get( const hbitset_t& h, uint32_t index )
+    {
+        SYS_ASSERT( index < h.level_size[0] );
+        return (h.bits[index / 64] >> (index & 63)) & 1;
+    }
+    inline void set( hbitset_t& h, uint32_t index )
+    {
+        SYS_ASSERT( index < h.level_size[0] );
+        h.bits[index / 64] |= 1ull << (index & 63);
+        _internal::update( h, index / 64 );
+    }
+    inline void clear( hbitset_t& h, uint32_t index )
+    {
+        SYS_ASSERT( index < h.level_size[0] );
+        h.bits[index / 64] &= ~(1ull << (index & 63));
+        _internal::update( h, index / 64 );
+    }
+
+    inline void set_all( hbitset_t& h )
+    {
+        const uint32_t count = _internal::nb_words( h.level_size[0] );
+        for( uint32_t i = 0; i < count; ++i )
+            h.bits[i] = bitset_words::valid_mask( h.level_size[0], i );
+        _internal::rebuild( h );
+    }
+    inline void clear_all( hbitset_t& h )
+    {
+        memset( h.bits, 0x00, _internal::nb_words( h.level_size[0] ) * sizeof( uint64_t ) );
+        _internal::rebuild( h );
+    }
+
+    // return hbitset_t::INVALID when there is no such bit
+    inline uint32_t find_first_set  ( const hbitset_t& h )                 { return _internal::find_next( h, true, 0, 0 ); }
+    inline uint32_t find_first_clear( const hbitset_t& h )                 { return _internal::find_next( h, false, 0, 0 ); }
+    inline uint32_t find_next_set   ( const hbitset_t& h, uint32_t begin ) { return _internal::find_next( h, true, 0, begin ); }
+    inline uint32_t find_next_clear ( const hbitset_t& h, uint32_t begin ) { return _internal::find_next( h, false, 0, begin ); }
+
+    inline uint32_t population( const hbitset_t& h )
+    {
+        return bitset_words::population( h.bits, _internal::nb_words( h.level_size[0] ) );
+    }
+
+    // calls 'func( bit_index )' for every set bit. Empty regions are skipped with upper levels
+    template< typename Tfunc >
+    inline void for_each_set( const hbitset_t& h, Tfunc func )
+    {
+        if( h.nb_levels == 1 )
+        {
+            bitset_words::for_each_set( h.bits, 1, func );
+            return;
+        }
+
+        for( uint32_t w = _internal::find_next( h, true, 1, 0 ); w != hbitset_t::INVALID; w = _internal::find_next( h, true, 1, w + 1 ) )
+        {
+            uint64_t value = h.bits[w];
+            while( value )
+            {
+                func( w * 64 + bitset_words::lowest_bit( value ) );
+                value &= value - 1;
+            }
+        }
+    }
+
+    // All sets have to be the same size. 'dst' can be the same as 'a' or 'b'
+    inline void op_and( hbitset_t& dst, const hbitset_t& a, const hbitset_t& b )
+    {
+        SYS_ASSERT( dst.level_size[0] == a.level_size[0] && a.level_size[0] == b.level_size[0] );
+        bitset_words::op_and( dst.bits, a.bits, b.bits, _internal::nb_words( dst.level_size[0] ) );
+        _internal::rebuild( dst );
+    }
+    inline void op_or( hbitset_t& dst, const hbitset_t& a, const hbitset_t& b )
+    {
+        SYS_ASSERT( dst.level_size[0] == a.level_size[0] && a.level_size[0] == b.level_size[0] );
+        bitset_words::op_or( dst.bits, a.bits, b.bits, _internal::nb_words( dst.level_size[0] ) );
+        _internal::rebuild( dst );
+    }
+    // dst = a & ~b
+    inline void op_andnot( hbitset_t& dst, const hbitset_t& a, const hbitset_t& b )
+    {
+        SYS_ASSERT( dst.level_size[0] == a.level_size[0] && a.level_size[0] == b.level_size[0] );
+        bitset_words::op_andnot( dst.bits, a.bits, b.bits, _internal::nb_words( dst.level_size[0] ) );
+        _internal::rebuild( dst );
+    }
+}//
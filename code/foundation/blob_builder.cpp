@@ -0,0 +1,148 @@
+#include "blob_builder.h"
+#include "debug.h"
+#include "common.h"
+#include "string_util.h"
+
+#include <string.h>
+
+blob_builder_t::~blob_builder_t()
+{
+    blob_builder::destroy( this );
+}
+
+namespace blob_builder
+{
+    static constexpr uint32_t MAX_ALIGNMENT = 64;
+
+    static void grow( blob_builder_t* b, uint32_t required_capacity )
+    {
+        uint32_t new_capacity = max_of_2( 256u, b->capacity * 2 );
+        while( new_capacity < required_capacity )
+            new_capacity *= 2;
+
+        // blob is always allocated with maximum alignment, so aligned positions stay aligned in memory
+        uint8_t* new_data = (uint8_t*)BX_MALLOC( b->allocator, new_capacity, MAX_ALIGNMENT );
+        memcpy( new_data, b->data, b->size );
+        memset( new_data + b->size, 0x00, new_capacity - b->size );
+
+        BX_FREE( b->allocator, b->data );
+        b->data = new_data;
+        b->capacity = new_capacity;
+    }
+
+    void create( blob_builder_t* b, uint32_t initial_capacity, BXIAllocator* allocator )
+    {
+        destroy( b );
+        b->allocator = allocator;
+        if( initial_capacity )
+        {
+            grow( b, initial_capacity );
+        }
+    }
+
+    void destroy( blob_builder_t* b )
+    {
+        if( b->allocator )
+        {
+            BX_FREE0( b->allocator, b->data );
+        }
+        b->size = 0;
+        b->capacity = 0;
+        b->alignment = 1;
+    }
+
+    blob_ref_t allocate( blob_builder_t* b, uint32_t size, uint32_t alignment )
+    {
+        SYS_ASSERT( b->allocator != nullptr );
+        SYS_ASSERT( alignment && alignment <= MAX_ALIGNMENT && (alignment & (alignment - 1)) == 0 );
+
+        const uint32_t pos = (uint32_t)TYPE_ALIGN( b->size, alignment );
+        if( pos + size > b->capacity )
+        {
+            grow( b, pos + size );
+        }
+
+        b->size = pos + size;
+        b->alignment = max_of_2( b->alignment, alignment );
+        return { pos };
+    }
+
+    blob_ref_t write( blob_builder_t* b, const void* data, uint32_t size, uint32_t alignment )
+    {
+        const blob_ref_t ref = allocate( b, size, alignment );
+        if( size )
+        {
+            memcpy( b->data + ref.pos, data, size );
+        }
+        return ref;
+    }
+
+    blob_ref_t write_string( blob_builder_t* b, const char* str )
+    {
+        return write( b, str, string::length( str ) + 1, 1 );
+    }
+
+    void link( blob_builder_t* b, blob_ref_t field, blob_ref_t target )
+    {
+        SYS_ASSERT( field.pos + sizeof( uint32_t ) <= b->size );
+
+        uint32_t offset = 0;
+        if( target.valid() )
+        {
+            // offsets are unsigned, so target always follows field
+            SYS_ASSERT( target.pos > field.pos );
+            offset = target.pos - field.pos;
+        }
+        memcpy( b->data + field.pos, &offset, sizeof( uint32_t ) );
+    }
+
+    void* pointer( blob_builder_t* b, blob_ref_t ref )
+    {
+        SYS_ASSERT( ref.valid() && ref.pos <= b->size );
+        return b->data + ref.pos;
+    }
+
+    blob_t release( blob_builder_t* b )
+    {
+        blob_t blob = {};
+        blob.raw = b->data;
+        blob.size = b->size;
+        blob.allocator = b->allocator;
+
+        b->data = nullptr;
+        destroy( b );
+        return blob;
+    }
+}//
+
+namespace blob_validate
+{
+    bool offset( const void* blob, uint32_t blob_size, const uint32_t& offset, uint32_t size, uint32_t alignment )
+    {
+        const uintptr_t begin = (uintptr_t)blob;
+        const uintptr_t end = begin + blob_size;
+        const uintptr_t field = (uintptr_t)&offset;
+        if( field < begin || field + sizeof( uint32_t ) > end )
+            return false;
+
+        if( offset == 0 )
+            return size == 0;
+
+        // computed in 64 bits, so huge offsets can't wrap around
+        const uint64_t target = (uint64_t)field + offset;
+        if( target + size > end )
+            return false;
+
+        return TYPE_IS_ALIGNED( target, alignment );
+    }
+
+    bool string( const void* blob, uint32_t blob_size, const uint32_t& offset )
+    {
+        if( !blob_validate::offset( blob, blob_size, offset, 1, 1 ) )
+            return false;
+
+        const char* str = Offset2Pointer<char>( offset );
+        const char* end = (const char*)blob + blob_size;
+        return memchr( str, 0, end - str ) != nullptr;
+    }
+}//
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "type.h"
+#include "blob.h"
+#include <memory/memory.h>
+#include <stddef.h>
+
+struct BXIAllocator;
+
+// Position of data written to blob. Memory moves when blob grows, so builder hands out positions instead of pointers
+struct blob_ref_t
+{
+    uint32_t pos = UINT32_MAX;
+    bool valid() const { return pos != UINT32_MAX; }
+};
+
+// Builds single block of memory with structs, arrays and strings which reference each other with self relative offsets
+// (the same TYPE_OFFSET_GET_POINTER and Offset2Pointer expect), so blob can be written to file and used in place after load.
+struct blob_builder_t
+{
+    uint8_t* data = nullptr;
+    uint32_t size = 0;
+    uint32_t capacity = 0;
+    uint32_t alignment = 1; // the biggest alignment requested so far
+    BXIAllocator* allocator = nullptr;
+
+    ~blob_builder_t();
+};
+
+namespace blob_builder
+{
+    void create( blob_builder_t* b, uint32_t initial_capacity, BXIAllocator* allocator );
+    void destroy( blob_builder_t* b );
+
+    // reserved memory is zeroed
+    blob_ref_t allocate    ( blob_builder_t* b, uint32_t size, uint32_t alignment );
+    blob_ref_t write       ( blob_builder_t* b, const void* data, uint32_t size, uint32_t alignment );
+    blob_ref_t write_string( blob_builder_t* b, const char* str );
+
+    // stores offset to 'target' in uint32_t located at 'field'. Invalid target stores null offset
+    void link( blob_builder_t* b, blob_ref_t field, blob_ref_t target );
+
+    // valid until next allocation
+    void* pointer( blob_builder_t* b, blob_ref_t ref );
+
+    // memory is handed over to blob (aligned to the biggest alignment used). Builder is empty after that
+    blob_t release( blob_builder_t* b );
+
+    inline blob_ref_t field( blob_ref_t base, uint32_t byte_offset ) { return { base.pos + byte_offset }; }
+
+    template< typename T > inline blob_ref_t allocate   ( blob_builder_t* b, uint32_t count = 1 )              { return allocate( b, sizeof( T ) * count, ALIGNOF( T ) ); }
+    template< typename T > inline blob_ref_t write      ( blob_builder_t* b, const T& value )                  { return write( b, &value, sizeof( T ), ALIGNOF( T ) ); }
+    template< typename T > inline blob_ref_t write_array( blob_builder_t* b, const T* values, uint32_t count ) { return write( b, values, sizeof( T ) * count, ALIGNOF( T ) ); }
+    template< typename T > inline T*         get        ( blob_builder_t* b, blob_ref_t ref )                  { return (T*)pointer( b, ref ); }
+}//
+
+// Offsets are checked once at load time, so they can be followed without any checks later
+namespace blob_validate
+{
+    // 'offset' has to lie inside blob. Returns true when 'size' bytes it points to are inside blob and aligned.
+    // Null offset is valid only for 'size' == 0
+    bool offset( const void* blob, uint32_t blob_size, const uint32_t& offset, uint32_t size, uint32_t alignment );
+    // string has to be null terminated inside blob
+    bool string( const void* blob, uint32_t blob_size, const uint32_t& offset );
+
+    template< typename T >
+    inline bool array( const void* blob, uint32_t blob_size, const uint32_t& offset, uint32_t count )
+    {
+        // computed in 64 bits, so huge count can't wrap around to small size
+        const uint64_t size = (uint64_t)sizeof( T ) * count;
+        if( size > blob_size )
+            return false;
+
+        return blob_validate::offset( blob, blob_size, offset, (uint32_t)size, ALIGNOF( T ) );
+    }
+}//
@@ -104,6 +104,29 @@ namespace c_array
         return index;
     }
 
+    template< typename T, typename... Targs >
+    T& emplace_back( c_array_t<T>*& arr, Targs&&... args )
+    {
+        SYS_ASSERT( arr != nullptr );
+
+        if( arr->size + 1 > arr->capacity )
+        {
+            const u32 new_capacity = (arr->size) ? arr->size * 2 : 8;
+            _internal::grow( arr, new_capacity, arr->allocator );
+        }
+
+        T* item = new( arr->data + arr->size ) T( std::forward<Targs>( args )... );
+        arr->size++;
+        return *item;
+    }
+
+    // the same as resize without value. Elements are never initialized by c_array
+    template< typename T >
+    void resize_uninitialized( c_array_t<T>*& arr, u32 size, BXIAllocator* allocator )
+    {
+        resize( arr, size, allocator );
+    }
+
     template< typename T >
     T pop_back( c_array_t<T>*& arr, const T& default_value = T() )
     {
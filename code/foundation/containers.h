@@ -3,6 +3,10 @@
 #include "type.h"
 #include "debug.h"
 #include <memory/memory.h>
+#include <string.h>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 //
 // dynamic array
@@ -86,6 +90,105 @@ struct c_array_t
     const T* end() const { return &data[0] + size; }
 };
 
+//
+// dynamic array with inline storage for N elements. Goes to allocator only when it grows past N (see small_array.h).
+// Unlike array_t, elements are constructed and destroyed properly, so T doesn't have to be POD
+//
+
+// Types which can be moved to other address with memcpy. Specialize for types which are not trivially copyable,
+// but don't keep pointers to themselves (eg. types which own heap memory)
+template< typename T > struct is_trivially_relocatable : std::is_trivially_copyable< T > {};
+
+namespace array_internal
+{
+    // moves 'count' elements to uninitialized memory. Source elements are destroyed
+    template< typename T > inline void relocate( T* dst, T* src, uint32_t count )
+    {
+        if( is_trivially_relocatable<T>::value )
+        {
+            memcpy( (void*)dst, (const void*)src, count * sizeof( T ) );
+        }
+        else
+        {
+            for( uint32_t i = 0; i < count; ++i )
+            {
+                new( dst + i ) T( std::move( src[i] ) );
+                src[i].~T();
+            }
+        }
+    }
+
+    template< typename T > inline void destruct( T* data, uint32_t count )
+    {
+        if( !std::is_trivially_destructible<T>::value )
+        {
+            for( uint32_t i = 0; i < count; ++i )
+                data[i].~T();
+        }
+    }
+}//
+
+template< typename T, uint32_t N >
+struct small_array_t
+{
+    using type_t = T;
+    static constexpr uint32_t INLINE_CAPACITY = N;
+
+    uint32_t size = 0;
+    uint32_t capacity = N;
+    T* data;
+    BXIAllocator* allocator;
+
+    explicit small_array_t( BXIAllocator* alloc = BXDefaultAllocator() )
+        : data( (T*)_inline ), allocator( alloc )
+    {
+        SYS_ASSERT( alloc != nullptr );
+    }
+
+    ~small_array_t()
+    {
+        array_internal::destruct( data, size );
+        if( !is_inline() )
+        {
+            BX_FREE( allocator, data );
+        }
+    }
+
+    small_array_t( small_array_t&& other )
+        : data( (T*)_inline ), allocator( other.allocator )
+    {
+        if( other.is_inline() )
+        {
+            array_internal::relocate( data, other.data, other.size );
+        }
+        else
+        {
+            data = other.data;
+            capacity = other.capacity;
+            other.data = (T*)other._inline;
+            other.capacity = N;
+        }
+        size = other.size;
+        other.size = 0;
+    }
+
+    small_array_t( const small_array_t& ) = delete;
+    small_array_t& operator = ( const small_array_t& ) = delete;
+
+    bool is_inline() const { return data == (const T*)_inline; }
+
+          T &operator[]( int i ) { return data[i]; }
+    const T &operator[]( int i ) const { return data[i]; }
+
+    T* begin() { return data; }
+    T* end  () { return data + size; }
+
+    const T* begin() const { return data; }
+    const T* end  () const { return data + size; }
+
+    alignas( T ) uint8_t _inline[N * sizeof( T )];
+};
+
 //
 // static array
 //
@@ -149,6 +252,11 @@ struct array_span_t
         : _begin( arr.begin() ), _size( arr.size )
     {}
 
+    template< uint32_t N >
+    explicit array_span_t( const small_array_t<T, N>& arr )
+        : _begin( arr.begin() ), _size( arr.size )
+    {}
+
     T* begin() { return _begin; }
     T* end() { return _begin + _size; }
 
@@ -230,17 +338,35 @@ struct hash_t
     using key_t = K;
 
     hash_t( BXIAllocator* a = BXDefaultAllocator() )
-        : _hash( a )
-        , _data( a )
+        : _data( a )
     {}
 
+    ~hash_t()
+    {
+        BX_FREE0( _data.allocator, _ctrl );
+    }
+
+    hash_t( hash_t&& other )
+        : _ctrl( other._ctrl ), _slots( other._slots ), _capacity( other._capacity ), _growth_left( other._growth_left )
+        , _data( static_cast<array_t<Entry>&&>( other._data ) )
+    {
+        other._ctrl = nullptr;
+        other._slots = nullptr;
+        other._capacity = 0;
+        other._growth_left = 0;
+    }
+
     struct Entry {
         key_t key;
-        uint32_t next;
         type_t value;
     };
 
-    array_t<uint32_t> _hash;
+    // Open addressing table. '_ctrl' holds one byte per slot (empty, deleted or 7 bits of key hash) and shares
+    // allocation with '_slots', which hold index of entry in '_data'. Entries are kept dense, so they can be iterated.
+    uint8_t*  _ctrl = nullptr;
+    uint32_t* _slots = nullptr;
+    uint32_t  _capacity = 0;
+    uint32_t  _growth_left = 0;
     array_t<Entry> _data;
 };
 
@@ -324,6 +450,64 @@ struct id_table_t
     Tid _ids[MAX];
 };
 
+//
+// growable generational slot map (see slot_map.h)
+// Tid is ID<> type (id.h). Its index bits decide max size, remaining bits hold generation.
+//
+struct slot_map_destroy_info_t
+{
+    uint32_t copy_data_from_index;
+    uint32_t copy_data_to_index;
+};
+
+template< typename Tid >
+struct slot_map_t
+{
+    using id_type = Tid;
+    using base_type = typename Tid::base_type;
+
+    static constexpr uint32_t INDEX_BITS = (uint32_t)Tid::NUM_IBITS;
+    static constexpr uint32_t GENERATION_BITS = (uint32_t)Tid::BASE_BITS - INDEX_BITS;
+    static_assert( INDEX_BITS <= 32 && GENERATION_BITS >= 1 && GENERATION_BITS < 64, "unsupported id layout" );
+
+    static constexpr base_type GENERATION_MASK = (base_type)((1ull << GENERATION_BITS) - 1);
+    static constexpr uint32_t MAX_SIZE = (uint32_t)((1ull << INDEX_BITS) - 1);
+
+    // slots live in pages, so they never move and growing doesn't copy them
+    static constexpr uint32_t PAGE_BITS = 12;
+    static constexpr uint32_t PAGE_SIZE = 1u << PAGE_BITS;
+    static constexpr uint32_t PAGE_MASK = PAGE_SIZE - 1;
+
+    // freed slots are reused in FIFO order and only when there are enough of them,
+    // so generation of single slot wraps around as late as possible
+    static constexpr uint32_t MIN_FREE_SLOTS = 1024;
+
+    struct Slot
+    {
+        base_type generation;
+        uint32_t dense; // dense index when alive, next free slot otherwise
+    };
+
+    explicit slot_map_t( BXIAllocator* allocator = BXDefaultAllocator() )
+        : _pages( allocator ), _dense_to_sparse( allocator )
+    {}
+    ~slot_map_t()
+    {
+        for( Slot* page : _pages )
+            BX_FREE( _pages.allocator, page );
+    }
+
+    slot_map_t( const slot_map_t& ) = delete;
+    slot_map_t& operator = ( const slot_map_t& ) = delete;
+
+    array_t<Slot*>    _pages;
+    array_t<uint32_t> _dense_to_sparse;
+    uint32_t _nb_slots = 0;
+    uint32_t _nb_free = 0;
+    uint32_t _free_head = 0;
+    uint32_t _free_tail = 0;
+};
+
 template< typename T > T makeInvalidHandle()
 {
     T h = { 0 };
@@ -345,6 +529,32 @@ struct bitset_t
     type_t bits[NUM_ELEMENTS] = {};
 };
 
+//
+// hierarchical bitset (see bitset.h). Size is set at runtime.
+// Every level above 'bits' has one bit per word of level below, so first set or clear bit is found
+// by looking at one word per level.
+//
+struct hbitset_t
+{
+    static constexpr uint32_t MAX_LEVELS = 5; // up to 64^5 bits
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    uint64_t* bits = nullptr;
+    uint64_t* any_set  [MAX_LEVELS] = {}; // [level] bit is set when word of level below has any bit set. [0] is unused
+    uint64_t* any_clear[MAX_LEVELS] = {}; // [level] bit is set when word of level below has any bit clear. [0] is unused
+    uint32_t  level_size[MAX_LEVELS] = {}; // number of bits in level
+    uint32_t  nb_levels = 0;
+    BXIAllocator* allocator = nullptr;
+
+    hbitset_t() = default;
+    hbitset_t( const hbitset_t& ) = delete;
+    hbitset_t& operator = ( const hbitset_t& ) = delete;
+    ~hbitset_t()
+    {
+        BX_FREE0( allocator, bits );
+    }
+};
+
 
 // TODO
 struct ring_t
@@ -459,3 +459,221 @@ unsigned crc32n( const unsigned char* data, unsigned len, unsigned init )
     return xcrc32( data, len, init );
 }
 
+
+//----------
+// crc32c
+
+#if defined( _MSC_VER )
+    #include <intrin.h>
+    #define BX_TARGET_SSE42
+#else
+    #include <cpuid.h>
+    #define BX_TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+#include <nmmintrin.h>
+#include <atomic>
+
+namespace
+{
+    static constexpr uint32_t CRC32C_POLY = 0x82f63b78; // reversed 0x1edc6f41
+
+    // t[0] is classic byte table, t[k][i] is t[k-1][i] advanced by one zero byte
+    struct Crc32cTables
+    {
+        uint32_t t[8][256];
+
+        constexpr Crc32cTables()
+            : t()
+        {
+            for( uint32_t i = 0; i < 256; ++i )
+            {
+                uint32_t crc = i;
+                for( uint32_t bit = 0; bit < 8; ++bit )
+                    crc = ( crc & 1 ) ? ( crc >> 1 ) ^ CRC32C_POLY : ( crc >> 1 );
+                t[0][i] = crc;
+            }
+            for( uint32_t i = 0; i < 256; ++i )
+            {
+                for( uint32_t k = 1; k < 8; ++k )
+                    t[k][i] = ( t[k - 1][i] >> 8 ) ^ t[0][t[k - 1][i] & 0xff];
+            }
+        }
+    };
+    static constexpr Crc32cTables _crc32c_tables;
+
+    static inline uint64_t load64( const uint8_t* p )
+    {
+        uint64_t v;
+        memcpy( &v, p, 8 );
+        return v;
+    }
+
+    static uint32_t crc32c_sliced( const uint8_t* p, size_t size, uint32_t crc )
+    {
+        const uint32_t( &t )[8][256] = _crc32c_tables.t;
+        for( ; size && ( (uintptr_t)p & 7 ); --size )
+            crc = ( crc >> 8 ) ^ t[0][( crc ^ *p++ ) & 0xff];
+
+        for( ; size >= 8; size -= 8, p += 8 )
+        {
+            const uint64_t v = load64( p ) ^ crc;
+            crc = t[7][( v       ) & 0xff] ^ t[6][( v >>  8 ) & 0xff] ^
+                  t[5][( v >> 16 ) & 0xff] ^ t[4][( v >> 24 ) & 0xff] ^
+                  t[3][( v >> 32 ) & 0xff] ^ t[2][( v >> 40 ) & 0xff] ^
+                  t[1][( v >> 48 ) & 0xff] ^ t[0][( v >> 56 )       ];
+        }
+
+        for( ; size; --size )
+            crc = ( crc >> 8 ) ^ t[0][( crc ^ *p++ ) & 0xff];
+
+        return crc;
+    }
+
+    BX_TARGET_SSE42 static uint32_t crc32c_sse42( const uint8_t* p, size_t size, uint32_t crc )
+    {
+        for( ; size && ( (uintptr_t)p & 7 ); --size )
+            crc = _mm_crc32_u8( crc, *p++ );
+
+#if defined( _M_X64 ) || defined( __x86_64__ )
+        uint64_t crc64 = crc;
+        for( ; size >= 8; size -= 8, p += 8 )
+            crc64 = _mm_crc32_u64( crc64, load64( p ) );
+        crc = (uint32_t)crc64;
+#else
+        for( ; size >= 4; size -= 4, p += 4 )
+        {
+            uint32_t v;
+            memcpy( &v, p, 4 );
+            crc = _mm_crc32_u32( crc, v );
+        }
+#endif
+        for( ; size; --size )
+            crc = _mm_crc32_u8( crc, *p++ );
+
+        return crc;
+    }
+
+    static bool cpu_has_sse42()
+    {
+#if defined( _MSC_VER )
+        int info[4] = {};
+        __cpuid( info, 1 );
+        return ( info[2] & ( 1 << 20 ) ) != 0;
+#else
+        unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+        return __get_cpuid( 1, &eax, &ebx, &ecx, &edx ) && ( ecx & ( 1 << 20 ) );
+#endif
+    }
+
+    using crc32c_func_t = uint32_t( *)( const uint8_t*, size_t, uint32_t );
+
+    // first call picks implementation. Doesn't depend on static initialization order
+    static uint32_t crc32c_resolve( const uint8_t* p, size_t size, uint32_t crc );
+    static std::atomic<crc32c_func_t> _crc32c_impl = { crc32c_resolve };
+
+    static uint32_t crc32c_resolve( const uint8_t* p, size_t size, uint32_t crc )
+    {
+        const crc32c_func_t func = ( cpu_has_sse42() ) ? crc32c_sse42 : crc32c_sliced;
+        _crc32c_impl.store( func, std::memory_order_relaxed );
+        return func( p, size, crc );
+    }
+}//
+
+uint32_t crc32c( const void* data, size_t size, uint32_t crc )
+{
+    const crc32c_func_t func = _crc32c_impl.load( std::memory_order_relaxed );
+    return ~func( (const uint8_t*)data, size, ~crc );
+}
+
+//----------
+// xxhash64
+
+namespace
+{
+    static constexpr uint64_t XXH_PRIME64_1 = BIG_CONSTANT( 0x9E3779B185EBCA87 );
+    static constexpr uint64_t XXH_PRIME64_2 = BIG_CONSTANT( 0xC2B2AE3D27D4EB4F );
+    static constexpr uint64_t XXH_PRIME64_3 = BIG_CONSTANT( 0x165667B19E3779F9 );
+    static constexpr uint64_t XXH_PRIME64_4 = BIG_CONSTANT( 0x85EBCA77C2B2AE63 );
+    static constexpr uint64_t XXH_PRIME64_5 = BIG_CONSTANT( 0x27D4EB2F165667C5 );
+
+    FORCE_INLINE uint64_t xxh64_round( uint64_t acc, uint64_t input )
+    {
+        acc += input * XXH_PRIME64_2;
+        acc = ROTL64( acc, 31 );
+        return acc * XXH_PRIME64_1;
+    }
+
+    FORCE_INLINE uint64_t xxh64_merge_round( uint64_t acc, uint64_t val )
+    {
+        acc ^= xxh64_round( 0, val );
+        return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+
+    FORCE_INLINE uint64_t xxh64_avalanche( uint64_t h64 )
+    {
+        h64 ^= h64 >> 33;
+        h64 *= XXH_PRIME64_2;
+        h64 ^= h64 >> 29;
+        h64 *= XXH_PRIME64_3;
+        h64 ^= h64 >> 32;
+        return h64;
+    }
+}//
+
+uint64_t xxhash64( const void* data, size_t size, uint64_t seed )
+{
+    const uint8_t* p = (const uint8_t*)data;
+    const uint8_t* const end = p + size;
+    uint64_t h64;
+
+    if( size >= 32 )
+    {
+        const uint8_t* const limit = end - 32;
+        uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+        uint64_t v2 = seed + XXH_PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXH_PRIME64_1;
+
+        do
+        {
+            v1 = xxh64_round( v1, load64( p      ) );
+            v2 = xxh64_round( v2, load64( p +  8 ) );
+            v3 = xxh64_round( v3, load64( p + 16 ) );
+            v4 = xxh64_round( v4, load64( p + 24 ) );
+            p += 32;
+        } while( p <= limit );
+
+        h64 = ROTL64( v1, 1 ) + ROTL64( v2, 7 ) + ROTL64( v3, 12 ) + ROTL64( v4, 18 );
+        h64 = xxh64_merge_round( h64, v1 );
+        h64 = xxh64_merge_round( h64, v2 );
+        h64 = xxh64_merge_round( h64, v3 );
+        h64 = xxh64_merge_round( h64, v4 );
+    }
+    else
+    {
+        h64 = seed + XXH_PRIME64_5;
+    }
+
+    h64 += (uint64_t)size;
+
+    for( ; p + 8 <= end; p += 8 )
+    {
+        h64 ^= xxh64_round( 0, load64( p ) );
+        h64 = ROTL64( h64, 27 ) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+    if( p + 4 <= end )
+    {
+        uint32_t v;
+        memcpy( &v, p, 4 );
+        h64 ^= (uint64_t)v * XXH_PRIME64_1;
+        h64 = ROTL64( h64, 23 ) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+    }
+    for( ; p < end; ++p )
+    {
+        h64 ^= (uint64_t)( *p ) * XXH_PRIME64_5;
+        h64 = ROTL64( h64, 11 ) * XXH_PRIME64_1;
+    }
+
+    return xxh64_avalanche( h64 );
+}
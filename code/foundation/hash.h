@@ -18,3 +18,81 @@ __forceinline void murmur3_hash128( void* out, const void* key, unsigned size8,
 unsigned crc32n( const unsigned char* data, unsigned len, unsigned init );
 unsigned crc32( const char* data, unsigned init );
 
+// CRC32C (Castagnoli). Uses SSE4.2 crc32 instruction when cpu has it (checked once with cpuid), slicing-by-8 otherwise.
+// Both give the same result. Pass result of previous call as 'crc' to continue hash of data split into parts.
+// It's different function than crc32n, values are not interchangeable
+uint32_t crc32c( const void* data, size_t size, uint32_t crc = 0 );
+
+// xxHash64. Fast hash for long buffers (file content, cache keys), not cryptographic
+uint64_t xxhash64( const void* data, size_t size, uint64_t seed = 0 );
+
+
+// constexpr versions, give the same values as functions above (little endian), so hash of literal can be computed by compiler.
+// Data is read byte by byte, so for long runtime data functions above are faster
+namespace constexpr_hash
+{
+    constexpr uint32_t length( const char* str )
+    {
+        uint32_t len = 0;
+        while( str[len] )
+            ++len;
+        return len;
+    }
+
+    constexpr uint32_t rotl32( uint32_t x, uint32_t r )
+    {
+        return ( x << r ) | ( x >> ( 32 - r ) );
+    }
+
+    constexpr uint32_t murmur3_hash32( const char* key, uint32_t len, uint32_t seed )
+    {
+        const uint32_t c1 = 0xcc9e2d51;
+        const uint32_t c2 = 0x1b873593;
+        const uint32_t nblocks = len / 4;
+
+        uint32_t h1 = seed;
+        for( uint32_t i = 0; i < nblocks; ++i )
+        {
+            const char* b = key + i * 4;
+            uint32_t k1 = (uint32_t)(uint8_t)b[0] | (uint32_t)(uint8_t)b[1] << 8 | (uint32_t)(uint8_t)b[2] << 16 | (uint32_t)(uint8_t)b[3] << 24;
+            k1 *= c1;
+            k1 = rotl32( k1, 15 );
+            k1 *= c2;
+
+            h1 ^= k1;
+            h1 = rotl32( h1, 13 );
+            h1 = h1 * 5 + 0xe6546b64;
+        }
+
+        const char* tail = key + nblocks * 4;
+        uint32_t k1 = 0;
+        switch( len & 3 )
+        {
+        case 3: k1 ^= (uint32_t)(uint8_t)tail[2] << 16;
+        case 2: k1 ^= (uint32_t)(uint8_t)tail[1] << 8;
+        case 1: k1 ^= (uint32_t)(uint8_t)tail[0];
+                k1 *= c1; k1 = rotl32( k1, 15 ); k1 *= c2; h1 ^= k1;
+        };
+
+        h1 ^= len;
+        h1 ^= h1 >> 16;
+        h1 *= 0x85ebca6b;
+        h1 ^= h1 >> 13;
+        h1 *= 0xc2b2ae35;
+        h1 ^= h1 >> 16;
+        return h1;
+    }
+
+    // the same as crc32n (msb first, polynomial 0x04c11db7, no final xor)
+    constexpr uint32_t crc32n( const char* data, uint32_t len, uint32_t init )
+    {
+        uint32_t crc = init;
+        for( uint32_t i = 0; i < len; ++i )
+        {
+            crc ^= (uint32_t)(uint8_t)data[i] << 24;
+            for( uint32_t bit = 0; bit < 8; ++bit )
+                crc = ( crc & 0x80000000 ) ? ( crc << 1 ) ^ 0x04c11db7 : ( crc << 1 );
+        }
+        return crc;
+    }
+}//
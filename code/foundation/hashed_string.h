@@ -1,35 +1,54 @@
 #pragma once
 
 #include "type.h"
+#include <type_traits>
 
 using hashed_string_t = uint64_t;
 
 namespace hashed_string_internal
 {
-    inline hashed_string_t hash_function( const char* str );
+    constexpr hashed_string_t hash_function( const char* str );
+    constexpr hashed_string_t hash_function( const char* str, size_t length );
 }
-inline hashed_string_t hashed_string( const char* str )
+// constexpr, so hash of literal can be computed by compiler. Use BX_HASHED_STRING to make sure it is
+constexpr hashed_string_t hashed_string( const char* str )
 {
     return hashed_string_internal::hash_function( str );
 }
+constexpr hashed_string_t hashed_string( const char* str, size_t length )
+{
+    return hashed_string_internal::hash_function( str, length );
+}
+
+// always evaluated at compile time, 'str' has to be literal
+#define BX_HASHED_STRING( str ) ( std::integral_constant<hashed_string_t, hashed_string( str )>::value )
 
 
 namespace hashed_string_internal
 {
-    inline hashed_string_t hash_function( const char* str )
-    {
-        static constexpr uint64_t OFFSET = 14695981039346656037;
-        static constexpr uint64_t PRIME = 1099511628211;
+    static constexpr uint64_t OFFSET = 14695981039346656037ull;
+    static constexpr uint64_t PRIME = 1099511628211ull;
 
+    constexpr hashed_string_t hash_function( const char* str )
+    {
         uint64_t hash = OFFSET;
-        unsigned char *s = (unsigned char *)str;
-        while( *s )
+        while( *str )
         {
             /* xor the bottom with the current octet */
-            hash ^= (uint64_t)*s++;
+            hash ^= (uint64_t)(uint8_t)*str++;
             /* multiply by the 64 bit FNV magic prime mod 2^64 */
             hash *= PRIME;
         }
         return hash;
     }
-}
\ No newline at end of file
+    constexpr hashed_string_t hash_function( const char* str, size_t length )
+    {
+        uint64_t hash = OFFSET;
+        for( size_t i = 0; i < length; ++i )
+        {
+            hash ^= (uint64_t)(uint8_t)str[i];
+            hash *= PRIME;
+        }
+        return hash;
+    }
+}
@@ -3,13 +3,33 @@
 #include "containers.h"
 #include "array.h"
 
-/// The hash function stores its data in a "list-in-an-array" where
-/// indices are used instead of pointers. 
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
+
+#if defined( _M_X64 ) || defined( _M_AMD64 ) || defined( __SSE2__ )
+#define BX_HASHMAP_SSE2 1
+#include <emmintrin.h>
+#else
+#define BX_HASHMAP_SSE2 0
+#endif
+
+/// Open addressing hash table (swiss table). Slots are probed in groups of 16 control bytes,
+/// which are compared with 7 bits of key hash at once (SSE2). Table size is power of two.
 ///
-/// When items are removed, the array-list is repacked to always keep
-/// it tightly ordered.
+/// Entries live in dense array, slots only point to them. When items are removed, the last
+/// entry is moved to the hole to always keep the array tightly ordered.
 
-inline u64 CalcHash( u64 key ) { return key; }
+/// Keys are often ids or already hashed strings with weak low bits, so they are mixed (murmur3 finalizer)
+inline u64 CalcHash( u64 key )
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
 
 namespace hash
 {
@@ -28,8 +48,8 @@ namespace hash
     /// Removes the key from the hash if it exists.
     template<BX_HASHMAP_TARGS_DECL> void remove( hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key );
 
-    /// Resizes the hash lookup table to the specified size.
-    /// (The table will grow automatically when 70 % full.)
+    /// Resizes the hash lookup table, so it can hold the specified number of entries without growing.
+    /// (The table will grow automatically when 87.5 % full.)
     template<BX_HASHMAP_TARGS_DECL> void reserve( hash_t<BX_HASHMAP_TARGS_INST> &h, uint32_t size );
 
     /// Remove all elements from the hash.
@@ -69,156 +89,233 @@ namespace multi_hash
 namespace hash_internal
 {
     const uint32_t END_OF_LIST = 0xffffffffu;
+    const uint32_t GROUP_WIDTH = 16;
+
+    const uint8_t CTRL_EMPTY   = 0x80;
+    const uint8_t CTRL_DELETED = 0xFE;
+    // full slots store 7 bits of hash, so top bit is clear
+
+    inline uint8_t  hash_h2( u64 key_hash ) { return (uint8_t)(key_hash & 0x7F); }
+    inline uint32_t hash_h1( u64 key_hash ) { return (uint32_t)(key_hash >> 7); }
 
-    struct FindResult
+    /// bit mask of slots in group which control byte equals 'value'
+    inline uint32_t group_match( const uint8_t* group, uint8_t value )
     {
-        uint32_t hash_i;
-        uint32_t data_prev;
-        uint32_t data_i;
-    };
+#if BX_HASHMAP_SSE2
+        const __m128i ctrl = _mm_load_si128( (const __m128i*)group );
+        return (uint32_t)_mm_movemask_epi8( _mm_cmpeq_epi8( ctrl, _mm_set1_epi8( (char)value ) ) );
+#else
+        uint32_t mask = 0;
+        for( uint32_t i = 0; i < GROUP_WIDTH; ++i )
+            mask |= uint32_t( group[i] == value ) << i;
+        return mask;
+#endif
+    }
 
-    template<BX_HASHMAP_TARGS_DECL> uint32_t add_entry( hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key )
+    /// bit mask of slots which are empty or deleted (top bit set)
+    inline uint32_t group_match_free( const uint8_t* group )
     {
-        typename hash_t<BX_HASHMAP_TARGS_INST>::Entry e;
-        e.key = key;
-        e.next = END_OF_LIST;
-        uint32_t ei = array::size( h._data );
-        array::push_back( h._data, e );
-        return ei;
+#if BX_HASHMAP_SSE2
+        return (uint32_t)_mm_movemask_epi8( _mm_load_si128( (const __m128i*)group ) );
+#else
+        uint32_t mask = 0;
+        for( uint32_t i = 0; i < GROUP_WIDTH; ++i )
+            mask |= uint32_t( group[i] >> 7 ) << i;
+        return mask;
+#endif
     }
 
-    template<BX_HASHMAP_TARGS_DECL> void erase( hash_t<BX_HASHMAP_TARGS_INST> &h, const FindResult &fr )
+    inline uint32_t lowest_bit( uint32_t mask )
     {
-        if( fr.data_prev == END_OF_LIST )
-            h._hash[fr.hash_i] = h._data[fr.data_i].next;
-        else
-            h._data[fr.data_prev].next = h._data[fr.data_i].next;
+#if defined( _MSC_VER )
+        unsigned long index;
+        _BitScanForward( &index, mask );
+        return (uint32_t)index;
+#else
+        return (uint32_t)__builtin_ctz( mask );
+#endif
+    }
 
-        array::pop_back( h._data );
+    /// Groups are visited in triangular order which covers every group when group count is power of two
+    struct Probe
+    {
+        uint32_t group;
+        uint32_t step;
+        uint32_t mask;
 
-        if( fr.data_i == array::size( h._data ) ) return;
+        Probe( u64 key_hash, uint32_t capacity )
+            : group( hash_h1( key_hash ) & ( capacity / GROUP_WIDTH - 1 ) ), step( 0 ), mask( capacity / GROUP_WIDTH - 1 ) {}
 
-        h._data[fr.data_i] = h._data[array::size( h._data )];
+        uint32_t offset() const { return group * GROUP_WIDTH; }
+        void next() { group = ( group + ++step ) & mask; }
+    };
 
-        FindResult last = find( h, h._data[fr.data_i].key );
+    inline uint32_t max_size_for_capacity( uint32_t capacity ) { return capacity - capacity / 8; }
 
-        if( last.data_prev != END_OF_LIST )
-            h._data[last.data_prev].next = fr.data_i;
-        else
-            h._hash[last.hash_i] = fr.data_i;
+    /// Returns slot which points to entry 'data_i'. Entry has to be in the table
+    template<BX_HASHMAP_TARGS_DECL> uint32_t find_slot( const hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key, uint32_t data_i )
+    {
+        const u64 key_hash = CalcHash( key );
+        const uint8_t h2 = hash_h2( key_hash );
+        for( Probe probe( key_hash, h._capacity );; probe.next() )
+        {
+            const uint32_t offset = probe.offset();
+            uint32_t match = group_match( h._ctrl + offset, h2 );
+            while( match )
+            {
+                const uint32_t slot = offset + lowest_bit( match );
+                if( h._slots[slot] == data_i )
+                    return slot;
+                match &= match - 1;
+            }
+            SYS_ASSERT( group_match( h._ctrl + offset, CTRL_EMPTY ) == 0 );
+        }
     }
 
-    template<BX_HASHMAP_TARGS_DECL> FindResult find( const hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key )
+    /// Returns first slot with 'key' which follows 'after_slot' in probe order (or first one for END_OF_LIST)
+    template<BX_HASHMAP_TARGS_DECL> uint32_t find( const hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key, uint32_t after_slot = END_OF_LIST )
     {
-        FindResult fr;
-        fr.hash_i = END_OF_LIST;
-        fr.data_prev = END_OF_LIST;
-        fr.data_i = END_OF_LIST;
-
-        if( array::size( h._hash ) == 0 )
-            return fr;
+        if( h._capacity == 0 )
+            return END_OF_LIST;
 
+        bool skip = after_slot != END_OF_LIST;
         const u64 key_hash = CalcHash( key );
-        fr.hash_i = key_hash % array::size( h._hash );
-        fr.data_i = h._hash[fr.hash_i];
-        while( fr.data_i != END_OF_LIST ) {
-            if( h._data[fr.data_i].key == key )
-                return fr;
-            fr.data_prev = fr.data_i;
-            fr.data_i = h._data[fr.data_i].next;
+        const uint8_t h2 = hash_h2( key_hash );
+        for( Probe probe( key_hash, h._capacity );; probe.next() )
+        {
+            const uint32_t offset = probe.offset();
+            const uint8_t* group = h._ctrl + offset;
+            uint32_t match = group_match( group, h2 );
+            while( match )
+            {
+                const uint32_t slot = offset + lowest_bit( match );
+                if( skip )
+                {
+                    skip = slot != after_slot;
+                }
+                else if( h._data[h._slots[slot]].key == key )
+                {
+                    return slot;
+                }
+                match &= match - 1;
+            }
+            
+            if( group_match( group, CTRL_EMPTY ) )
+                return END_OF_LIST;
         }
-        return fr;
     }
 
-    template<BX_HASHMAP_TARGS_DECL> FindResult find( const hash_t<BX_HASHMAP_TARGS_INST> &h, const typename hash_t<BX_HASHMAP_TARGS_INST>::Entry *e )
+    /// First empty or deleted slot on probe sequence
+    template<BX_HASHMAP_TARGS_DECL> uint32_t find_free( const hash_t<BX_HASHMAP_TARGS_INST> &h, u64 key_hash )
     {
-        FindResult fr;
-        fr.hash_i = END_OF_LIST;
-        fr.data_prev = END_OF_LIST;
-        fr.data_i = END_OF_LIST;
-
-        if( array::size( h._hash ) == 0 )
-            return fr;
-
-        fr.hash_i = e->key % array::size( h._hash );
-        fr.data_i = h._hash[fr.hash_i];
-        while( fr.data_i != END_OF_LIST ) {
-            if( &h._data[fr.data_i] == e )
-                return fr;
-            fr.data_prev = fr.data_i;
-            fr.data_i = h._data[fr.data_i].next;
+        for( Probe probe( key_hash, h._capacity );; probe.next() )
+        {
+            const uint32_t offset = probe.offset();
+            const uint32_t mask = group_match_free( h._ctrl + offset );
+            if( mask )
+                return offset + lowest_bit( mask );
         }
-        return fr;
     }
 
-    template<BX_HASHMAP_TARGS_DECL> uint32_t find_or_fail( const hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key )
+    template<BX_HASHMAP_TARGS_DECL> void set_slot( hash_t<BX_HASHMAP_TARGS_INST> &h, u64 key_hash, uint32_t data_i )
     {
-        return find( h, key ).data_i;
+        const uint32_t slot = find_free( h, key_hash );
+        if( h._ctrl[slot] == CTRL_EMPTY )
+            h._growth_left -= 1;
+
+        h._ctrl[slot] = hash_h2( key_hash );
+        h._slots[slot] = data_i;
     }
 
-    template<BX_HASHMAP_TARGS_DECL> uint32_t find_or_make( hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key )
+    template<BX_HASHMAP_TARGS_DECL> void rehash( hash_t<BX_HASHMAP_TARGS_INST> &h, uint32_t new_capacity )
     {
-        const FindResult fr = find( h, key );
-        if( fr.data_i != END_OF_LIST )
-            return fr.data_i;
+        SYS_ASSERT( new_capacity >= GROUP_WIDTH && ( new_capacity & ( new_capacity - 1 ) ) == 0 );
+        SYS_ASSERT( max_size_for_capacity( new_capacity ) >= array::size( h._data ) );
 
-        uint32_t i = add_entry( h, key );
-        if( fr.data_prev == END_OF_LIST )
-            h._hash[fr.hash_i] = i;
-        else
-            h._data[fr.data_prev].next = i;
-        return i;
+        BXIAllocator* allocator = h._data.allocator;
+        BX_FREE0( allocator, h._ctrl );
+
+        uint8_t* memory = (uint8_t*)BX_MALLOC( allocator, new_capacity * ( sizeof( uint8_t ) + sizeof( uint32_t ) ), GROUP_WIDTH );
+        h._ctrl = memory;
+        h._slots = (uint32_t*)( memory + new_capacity );
+        h._capacity = new_capacity;
+        h._growth_left = max_size_for_capacity( new_capacity );
+        memset( h._ctrl, CTRL_EMPTY, new_capacity );
+
+        for( uint32_t i = 0; i < array::size( h._data ); ++i )
+            set_slot( h, CalcHash( h._data[i].key ), i );
     }
 
-    template<BX_HASHMAP_TARGS_DECL> uint32_t make( hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key )
+    template<BX_HASHMAP_TARGS_DECL> void reserve_slot( hash_t<BX_HASHMAP_TARGS_INST> &h )
     {
-        const FindResult fr = find( h, key );
-        const uint32_t i = add_entry( h, key );
-
-        if( fr.data_prev == END_OF_LIST )
-            h._hash[fr.hash_i] = i;
+        if( h._growth_left )
+            return;
+
+        // table which is mostly tombstones is only cleaned up, otherwise it's doubled
+        const uint32_t size = array::size( h._data );
+        if( h._capacity == 0 )
+            rehash( h, GROUP_WIDTH );
+        else if( size + 1 <= max_size_for_capacity( h._capacity ) / 2 )
+            rehash( h, h._capacity );
         else
-            h._data[fr.data_prev].next = i;
-
-        h._data[i].next = fr.data_i;
-        return i;
+            rehash( h, h._capacity * 2 );
     }
 
-    template<BX_HASHMAP_TARGS_DECL> void find_and_erase( hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key )
+    template<BX_HASHMAP_TARGS_DECL> uint32_t add_entry( hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key )
     {
-        const FindResult fr = find( h, key );
-        if( fr.data_i != END_OF_LIST )
-            erase( h, fr );
+        reserve_slot( h );
+
+        typename hash_t<BX_HASHMAP_TARGS_INST>::Entry e;
+        e.key = key;
+        const uint32_t ei = array::size( h._data );
+        array::push_back( h._data, e );
+        set_slot( h, CalcHash( key ), ei );
+        return ei;
     }
 
-    template<BX_HASHMAP_TARGS_DECL> void rehash( hash_t<BX_HASHMAP_TARGS_INST> &h, uint32_t new_size )
+    template<BX_HASHMAP_TARGS_DECL> void erase( hash_t<BX_HASHMAP_TARGS_INST> &h, uint32_t slot )
     {
-        hash_t<BX_HASHMAP_TARGS_INST> nh( h._hash.allocator );
-        array::resize( nh._hash, new_size );
-        array::reserve( nh._data, array::size( h._data ) );
-        for( uint32_t i = 0; i < new_size; ++i )
-            nh._hash[i] = END_OF_LIST;
-        for( uint32_t i = 0; i < array::size( h._data ); ++i ) {
-            const typename hash_t<BX_HASHMAP_TARGS_INST>::Entry &e = h._data[i];
-            multi_hash::insert( nh, e.key, e.value );
+        const uint32_t data_i = h._slots[slot];
+
+        // slot can become empty again only when no probe sequence has passed through its (full) group
+        const uint32_t group_offset = slot & ~( GROUP_WIDTH - 1 );
+        if( group_match( h._ctrl + group_offset, CTRL_EMPTY ) )
+        {
+            h._ctrl[slot] = CTRL_EMPTY;
+            h._growth_left += 1;
+        }
+        else
+        {
+            h._ctrl[slot] = CTRL_DELETED;
         }
 
-        hash_t<BX_HASHMAP_TARGS_INST> empty( h._hash.allocator );
-        h.~hash_t<BX_HASHMAP_TARGS_INST>();
-        memcpy( &h, &nh, sizeof( hash_t<BX_HASHMAP_TARGS_INST> ) );
-        memcpy( &nh, &empty, sizeof( hash_t<BX_HASHMAP_TARGS_INST> ) );
+        const uint32_t last_i = array::size( h._data ) - 1;
+        if( data_i != last_i )
+        {
+            const uint32_t last_slot = find_slot( h, h._data[last_i].key, last_i );
+            h._data[data_i] = h._data[last_i];
+            h._slots[last_slot] = data_i;
+        }
+        array::pop_back( h._data );
     }
 
-    template<BX_HASHMAP_TARGS_DECL> bool full( const hash_t<BX_HASHMAP_TARGS_INST> &h )
+    template<BX_HASHMAP_TARGS_DECL> uint32_t find_or_fail( const hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key )
     {
-        const float max_load_factor = 0.7f;
-        return array::size( h._data ) >= array::size( h._hash ) * max_load_factor;
+        const uint32_t slot = find( h, key );
+        return ( slot == END_OF_LIST ) ? END_OF_LIST : h._slots[slot];
     }
 
-    template<BX_HASHMAP_TARGS_DECL> void grow( hash_t<BX_HASHMAP_TARGS_INST> &h )
+    template<BX_HASHMAP_TARGS_DECL> uint32_t find_or_make( hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key )
+    {
+        const uint32_t i = find_or_fail( h, key );
+        return ( i != END_OF_LIST ) ? i : add_entry( h, key );
+    }
+
+    template<BX_HASHMAP_TARGS_DECL> void find_and_erase( hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key )
     {
-        const uint32_t new_size = array::size( h._data ) * 2 + 10;
-        rehash( h, new_size );
+        const uint32_t slot = find( h, key );
+        if( slot != END_OF_LIST )
+            erase( h, slot );
     }
 }
 
@@ -237,13 +334,8 @@ namespace hash
 
     template<BX_HASHMAP_TARGS_DECL> void set( hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key, const T &value )
     {
-        if( array::size( h._hash ) == 0 )
-            hash_internal::grow( h );
-
         const uint32_t i = hash_internal::find_or_make( h, key );
         h._data[i].value = value;
-        if( hash_internal::full( h ) )
-            hash_internal::grow( h );
     }
 
     template<BX_HASHMAP_TARGS_DECL> void remove( hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key )
@@ -253,13 +345,25 @@ namespace hash
 
     template<BX_HASHMAP_TARGS_DECL> void reserve( hash_t<BX_HASHMAP_TARGS_INST> &h, uint32_t size )
     {
-        hash_internal::rehash( h, size );
+        uint32_t capacity = hash_internal::GROUP_WIDTH;
+        while( hash_internal::max_size_for_capacity( capacity ) < size )
+            capacity *= 2;
+
+        if( capacity > h._capacity )
+        {
+            array::reserve( h._data, (int)size );
+            hash_internal::rehash( h, capacity );
+        }
     }
 
     template<BX_HASHMAP_TARGS_DECL> void clear( hash_t<BX_HASHMAP_TARGS_INST> &h )
     {
         array::clear( h._data );
-        array::clear( h._hash );
+        if( h._capacity )
+        {
+            memset( h._ctrl, hash_internal::CTRL_EMPTY, h._capacity );
+            h._growth_left = hash_internal::max_size_for_capacity( h._capacity );
+        }
     }
 
     template<BX_HASHMAP_TARGS_DECL> const typename hash_t<BX_HASHMAP_TARGS_INST>::Entry *begin( const hash_t<BX_HASHMAP_TARGS_INST> &h )
@@ -283,13 +387,10 @@ namespace multi_hash
 
     template<BX_HASHMAP_TARGS_DECL> const typename hash_t<BX_HASHMAP_TARGS_INST>::Entry *find_next( const hash_t<BX_HASHMAP_TARGS_INST> &h, const typename hash_t<BX_HASHMAP_TARGS_INST>::Entry *e )
     {
-        uint32_t i = e->next;
-        while( i != hash_internal::END_OF_LIST ) {
-            if( h._data[i].key == e->key )
-                return &h._data[i];
-            i = h._data[i].next;
-        }
-        return 0;
+        const uint32_t data_i = (uint32_t)( e - array::begin( h._data ) );
+        const uint32_t slot = hash_internal::find_slot( h, e->key, data_i );
+        const uint32_t next_slot = hash_internal::find( h, e->key, slot );
+        return next_slot == hash_internal::END_OF_LIST ? 0 : &h._data[h._slots[next_slot]];
     }
 
     template<BX_HASHMAP_TARGS_DECL> uint32_t count( const hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key )
@@ -314,25 +415,24 @@ namespace multi_hash
 
     template<BX_HASHMAP_TARGS_DECL> void insert( hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key, const T &value )
     {
-        if( array::size( h._hash ) == 0 )
-            hash_internal::grow( h );
-
-        const uint32_t i = hash_internal::make( h, key );
+        const uint32_t i = hash_internal::add_entry( h, key );
         h._data[i].value = value;
-        if( hash_internal::full( h ) )
-            hash_internal::grow( h );
     }
 
     template<BX_HASHMAP_TARGS_DECL> void remove( hash_t<BX_HASHMAP_TARGS_INST> &h, const typename hash_t<BX_HASHMAP_TARGS_INST>::Entry *e )
     {
-        const hash_internal::FindResult fr = hash_internal::find( h, e );
-        if( fr.data_i != hash_internal::END_OF_LIST )
-            hash_internal::erase( h, fr );
+        const uint32_t data_i = (uint32_t)( e - array::begin( h._data ) );
+        if( data_i < array::size( h._data ) )
+            hash_internal::erase( h, hash_internal::find_slot( h, e->key, data_i ) );
     }
 
     template<BX_HASHMAP_TARGS_DECL> void remove_all( hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key )
     {
-        while( hash::has( h, key ) )
-            hash::remove( h, key );
+        uint32_t slot = hash_internal::find( h, key );
+        while( slot != hash_internal::END_OF_LIST )
+        {
+            hash_internal::erase( h, slot );
+            slot = hash_internal::find( h, key );
+        }
     }
 }
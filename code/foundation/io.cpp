@@ -33,7 +33,10 @@ int32_t ReadFile( uint8_t** outBuffer, uint32_t* outSizeInBytes, const char* pat
 	{
 		return IO_ERROR;
 	}
-
+	return ReadFile( outBuffer, outSizeInBytes, f, allocator );
+}
+int32_t ReadFile( uint8_t** outBuffer, uint32_t* outSizeInBytes, FILE* f, BXIAllocator* allocator )
+{
 	fseek( f, 0, SEEK_END );
 	uint32_t sizeInBytes = (uint32_t)ftell( f );
 	fseek( f, 0, SEEK_SET );
@@ -57,7 +60,10 @@ int32_t ReadTextFile( uint8_t** outBuffer, uint32_t* outSizeInBytes, const char*
 	{
 		return IO_ERROR;
 	}
-
+	return ReadTextFile( outBuffer, outSizeInBytes, f, allocator );
+}
+int32_t ReadTextFile( uint8_t** outBuffer, uint32_t* outSizeInBytes, FILE* f, BXIAllocator* allocator )
+{
 	fseek( f, 0, SEEK_END );
 	uint32_t sizeInBytes = (uint32_t)ftell( f );
 	fseek( f, 0, SEEK_SET );
@@ -76,6 +82,65 @@ int32_t ReadTextFile( uint8_t** outBuffer, uint32_t* outSizeInBytes, const char*
 
 	return IO_OK;
 }
+int32_t ReadFileChunked( const char* path, uint32_t chunkSize, ReadFileChunkCallback* callback, void* userData, BXIAllocator* allocator )
+{
+	SYS_ASSERT( chunkSize > 0 );
+
+	// 'S' hints sequential access, so OS reads ahead while callback is processing current chunk
+	FILE* f = OpenFile( path, "rbS" );
+	if( !f )
+	{
+		return IO_ERROR;
+	}
+	return ReadFileChunked( f, chunkSize, callback, userData, allocator );
+}
+int32_t ReadFileChunked( FILE* f, uint32_t chunkSize, ReadFileChunkCallback* callback, void* userData, BXIAllocator* allocator )
+{
+	SYS_ASSERT( chunkSize > 0 );
+
+	fseek( f, 0, SEEK_END );
+	const uint32_t sizeInBytes = (uint32_t)ftell( f );
+	fseek( f, 0, SEEK_SET );
+
+	// empty file still gets one call, so caller always sees the beginning of stream
+	if( sizeInBytes == 0 )
+	{
+		const int32_t result = ( callback( nullptr, 0, 0, 0, userData ) ) ? IO_OK : IO_ERROR;
+		int ret = fclose( f );
+		SYS_ASSERT( ret != EOF );
+		return result;
+	}
+
+	uint8_t* buf = (uint8_t*)BX_MALLOC( allocator, chunkSize, 16 );
+	SYS_ASSERT( buf && "out of memory?" );
+
+	int32_t result = IO_OK;
+	uint32_t offset = 0;
+	while( offset < sizeInBytes )
+	{
+		const uint32_t toRead = ( sizeInBytes - offset < chunkSize ) ? sizeInBytes - offset : chunkSize;
+		const size_t readBytes = fread( buf, 1, toRead, f );
+		if( readBytes != toRead )
+		{
+			SYS_LOG_ERROR( "Can't read chunk at offset %u (size: %u)\n", offset, sizeInBytes );
+			result = IO_ERROR;
+			break;
+		}
+
+		if( !callback( buf, toRead, offset, sizeInBytes, userData ) )
+		{
+			result = IO_ERROR;
+			break;
+		}
+		offset += toRead;
+	}
+
+	BX_FREE( allocator, buf );
+	int ret = fclose( f );
+	SYS_ASSERT( ret != EOF );
+
+	return result;
+}
 int32_t WriteFile( const char* absPath, const void* buf, size_t sizeInBytes )
 {
 	FILE* fp = OpenFile( absPath, "wb" );
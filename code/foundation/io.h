@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdio.h>
+
 
 enum EIOResult : int
 {
@@ -10,6 +12,17 @@ enum EIOResult : int
 struct BXIAllocator;
 int ReadFile    ( unsigned char** outBuffer, unsigned* outSizeInBytes, const char* path, BXIAllocator* allocator );
 int ReadTextFile( unsigned char** outBuffer, unsigned* outSizeInBytes, const char* path, BXIAllocator* allocator );
+
+// called for each consecutive chunk of file. Returning false stops reading.
+// Empty file gets exactly one call with (nullptr, 0, 0, 0)
+using ReadFileChunkCallback = bool( const void* chunk, unsigned chunkSize, unsigned offset, unsigned totalSize, void* userData );
+int ReadFileChunked( const char* path, unsigned chunkSize, ReadFileChunkCallback* callback, void* userData, BXIAllocator* allocator );
+
+// the same as above, but read already opened file. File is closed when function returns
+int ReadFile       ( unsigned char** outBuffer, unsigned* outSizeInBytes, FILE* file, BXIAllocator* allocator );
+int ReadTextFile   ( unsigned char** outBuffer, unsigned* outSizeInBytes, FILE* file, BXIAllocator* allocator );
+int ReadFileChunked( FILE* file, unsigned chunkSize, ReadFileChunkCallback* callback, void* userData, BXIAllocator* allocator );
+
 int WriteFile   ( const char* absPath, const void* buf, size_t sizeInBytes );
 int CopyFile    ( const char* absDstPath, const char* absSrcPath, BXIAllocator* allocator );
 int CreateDir   ( const char* absPath );
\ No newline at end of file
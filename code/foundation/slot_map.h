@@ -0,0 +1,188 @@
+#pragma once
+
+#include "containers.h"
+#include "array.h"
+#include "id.h"
+
+// Default handle: 24 bit index (16M slots), 8 bit generation. Handle with hash 0 is never valid.
+// Define own handle with BX_DEFINE_ID when different split is needed (eg. u64 with 32 bit index and 32 bit generation).
+BX_DEFINE_ID( slot_id_t, u32, 24 );
+
+// Ids are stable, data is kept densely packed by user (same as with id_array):
+// create() appends dense entry, destroy() returns which entry has to be moved to fill the hole.
+
+#define BX_SLOT_MAP_T_DEF typename Tid
+#define BX_SLOT_MAP_T_ARG Tid
+
+namespace slot_map_internal
+{
+    template <BX_SLOT_MAP_T_DEF>
+    inline typename slot_map_t<BX_SLOT_MAP_T_ARG>::Slot& slot( slot_map_t<BX_SLOT_MAP_T_ARG>& m, uint32_t index )
+    {
+        using map_t = slot_map_t<BX_SLOT_MAP_T_ARG>;
+        return m._pages[index >> map_t::PAGE_BITS][index & map_t::PAGE_MASK];
+    }
+    template <BX_SLOT_MAP_T_DEF>
+    inline const typename slot_map_t<BX_SLOT_MAP_T_ARG>::Slot& slot( const slot_map_t<BX_SLOT_MAP_T_ARG>& m, uint32_t index )
+    {
+        using map_t = slot_map_t<BX_SLOT_MAP_T_ARG>;
+        return m._pages[index >> map_t::PAGE_BITS][index & map_t::PAGE_MASK];
+    }
+
+    template <BX_SLOT_MAP_T_DEF>
+    inline void add_pages( slot_map_t<BX_SLOT_MAP_T_ARG>& m, uint32_t nb_slots )
+    {
+        using map_t = slot_map_t<BX_SLOT_MAP_T_ARG>;
+        using Slot = typename map_t::Slot;
+
+        const uint32_t nb_pages = (nb_slots + map_t::PAGE_MASK) >> map_t::PAGE_BITS;
+        while( array::size( m._pages ) < nb_pages )
+        {
+            Slot* page = (Slot*)BX_MALLOC( m._pages.allocator, map_t::PAGE_SIZE * sizeof( Slot ), ALIGNOF( Slot ) );
+            array::push_back( m._pages, page );
+        }
+    }
+
+    template <BX_SLOT_MAP_T_DEF>
+    inline typename slot_map_t<BX_SLOT_MAP_T_ARG>::base_type next_generation( typename slot_map_t<BX_SLOT_MAP_T_ARG>::base_type generation )
+    {
+        generation = (generation + 1) & slot_map_t<BX_SLOT_MAP_T_ARG>::GENERATION_MASK;
+        return (generation) ? generation : 1;
+    }
+
+    template <BX_SLOT_MAP_T_DEF>
+    inline Tid make_id( uint32_t index, typename slot_map_t<BX_SLOT_MAP_T_ARG>::base_type generation )
+    {
+        Tid id( 0 );
+        id.index = index;
+        id.generation = generation;
+        return id;
+    }
+}//
+
+namespace slot_map
+{
+    template <BX_SLOT_MAP_T_DEF>
+    inline bool has( const slot_map_t<BX_SLOT_MAP_T_ARG>& m, Tid id )
+    {
+        const uint32_t index = (uint32_t)id.index;
+        if( index >= m._nb_slots )
+            return false;
+
+        // free slot keeps link to next free slot in 'dense', so dense entry has to point back to make sure slot is alive
+        const auto& s = slot_map_internal::slot( m, index );
+        return s.generation == id.generation && s.dense < m._dense_to_sparse.size && m._dense_to_sparse[s.dense] == index;
+    }
+
+    template <BX_SLOT_MAP_T_DEF>
+    inline Tid create( slot_map_t<BX_SLOT_MAP_T_ARG>& m )
+    {
+        using map_t = slot_map_t<BX_SLOT_MAP_T_ARG>;
+
+        uint32_t index = 0;
+        if( m._nb_free > map_t::MIN_FREE_SLOTS || (m._nb_free && m._nb_slots == map_t::MAX_SIZE) )
+        {
+            index = m._free_head;
+            m._free_head = slot_map_internal::slot( m, index ).dense;
+            m._nb_free--;
+        }
+        else
+        {
+            SYS_ASSERT_TXT( m._nb_slots < map_t::MAX_SIZE, "SlotMap full" );
+            index = m._nb_slots++;
+            slot_map_internal::add_pages( m, m._nb_slots );
+            slot_map_internal::slot( m, index ).generation = 1;
+        }
+
+        auto& s = slot_map_internal::slot( m, index );
+        s.dense = m._dense_to_sparse.size;
+        array::push_back( m._dense_to_sparse, index );
+
+        return slot_map_internal::make_id<BX_SLOT_MAP_T_ARG>( index, s.generation );
+    }
+
+    // id changes, slot and dense index stay the same
+    template <BX_SLOT_MAP_T_DEF>
+    inline Tid invalidate( slot_map_t<BX_SLOT_MAP_T_ARG>& m, Tid id )
+    {
+        SYS_ASSERT_TXT( has( m, id ), "SlotMap does not have ID: %u,%u", (uint32_t)id.generation, (uint32_t)id.index );
+
+        auto& s = slot_map_internal::slot( m, (uint32_t)id.index );
+        s.generation = slot_map_internal::next_generation<BX_SLOT_MAP_T_ARG>( s.generation );
+        return slot_map_internal::make_id<BX_SLOT_MAP_T_ARG>( (uint32_t)id.index, s.generation );
+    }
+
+    template <BX_SLOT_MAP_T_DEF>
+    inline slot_map_destroy_info_t destroy( slot_map_t<BX_SLOT_MAP_T_ARG>& m, Tid id )
+    {
+        SYS_ASSERT_TXT( has( m, id ), "SlotMap does not have ID: %u,%u", (uint32_t)id.generation, (uint32_t)id.index );
+
+        const uint32_t index = (uint32_t)id.index;
+        auto& s = slot_map_internal::slot( m, index );
+
+        // Swap with last element
+        const uint32_t last = m._dense_to_sparse.size - 1;
+        slot_map_destroy_info_t ret;
+        ret.copy_data_from_index = last;
+        ret.copy_data_to_index = s.dense;
+
+        const uint32_t moved = m._dense_to_sparse[last];
+        m._dense_to_sparse[s.dense] = moved;
+        slot_map_internal::slot( m, moved ).dense = s.dense;
+        array::pop_back( m._dense_to_sparse );
+
+        // append to free list
+        s.generation = slot_map_internal::next_generation<BX_SLOT_MAP_T_ARG>( s.generation );
+        if( m._nb_free )
+            slot_map_internal::slot( m, m._free_tail ).dense = index;
+        else
+            m._free_head = index;
+
+        m._free_tail = index;
+        m._nb_free++;
+
+        return ret;
+    }
+
+    template <BX_SLOT_MAP_T_DEF>
+    inline void destroy_all( slot_map_t<BX_SLOT_MAP_T_ARG>& m )
+    {
+        while( m._dense_to_sparse.size )
+        {
+            const uint32_t index = array::back( m._dense_to_sparse );
+            destroy( m, slot_map_internal::make_id<BX_SLOT_MAP_T_ARG>( index, slot_map_internal::slot( m, index ).generation ) );
+        }
+    }
+
+    // dense index of id
+    template <BX_SLOT_MAP_T_DEF>
+    inline uint32_t index( const slot_map_t<BX_SLOT_MAP_T_ARG>& m, Tid id )
+    {
+        SYS_ASSERT_TXT( has( m, id ), "SlotMap does not have ID: %u,%u", (uint32_t)id.generation, (uint32_t)id.index );
+        return slot_map_internal::slot( m, (uint32_t)id.index ).dense;
+    }
+
+    template <BX_SLOT_MAP_T_DEF>
+    inline Tid id( const slot_map_t<BX_SLOT_MAP_T_ARG>& m, uint32_t dense_index )
+    {
+        SYS_ASSERT_TXT( dense_index < m._dense_to_sparse.size, "Invalid index" );
+        const uint32_t index = m._dense_to_sparse[dense_index];
+        return slot_map_internal::make_id<BX_SLOT_MAP_T_ARG>( index, slot_map_internal::slot( m, index ).generation );
+    }
+
+    template <BX_SLOT_MAP_T_DEF>
+    inline uint32_t size( const slot_map_t<BX_SLOT_MAP_T_ARG>& m )
+    {
+        return m._dense_to_sparse.size;
+    }
+
+    // preallocates slot pages and dense table, so first 'count' creates don't allocate
+    template <BX_SLOT_MAP_T_DEF>
+    inline void reserve( slot_map_t<BX_SLOT_MAP_T_ARG>& m, uint32_t count )
+    {
+        SYS_ASSERT( count <= slot_map_t<BX_SLOT_MAP_T_ARG>::MAX_SIZE );
+        slot_map_internal::add_pages( m, count );
+        if( count > m._dense_to_sparse.capacity )
+            array::reserve( m._dense_to_sparse, (int)count );
+    }
+}//
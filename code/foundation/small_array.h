@@ -0,0 +1,147 @@
+#pragma once
+
+#include "containers.h"
+
+namespace array_internal
+{
+    template< typename T, uint32_t N > void _Grow( small_array_t<T, N>& arr, uint32_t new_capacity )
+    {
+        SYS_ASSERT( new_capacity > arr.capacity );
+
+        T* new_data = (T*)BX_MALLOC( arr.allocator, sizeof( T ) * new_capacity, ALIGNOF( T ) );
+        relocate( new_data, arr.data, arr.size );
+        if( !arr.is_inline() )
+        {
+            BX_FREE( arr.allocator, arr.data );
+        }
+        arr.data = new_data;
+        arr.capacity = new_capacity;
+    }
+}//
+
+namespace array
+{
+    template< typename T, uint32_t N > T*       begin   ( small_array_t<T, N>& arr )       { return arr.data; }
+    template< typename T, uint32_t N > T*       end     ( small_array_t<T, N>& arr )       { return arr.data + arr.size; }
+    template< typename T, uint32_t N > const T* begin   ( const small_array_t<T, N>& arr ) { return arr.data; }
+    template< typename T, uint32_t N > const T* end     ( const small_array_t<T, N>& arr ) { return arr.data + arr.size; }
+    template< typename T, uint32_t N > int      capacity( const small_array_t<T, N>& arr ) { return arr.capacity; }
+    template< typename T, uint32_t N > uint32_t size    ( const small_array_t<T, N>& arr ) { return arr.size; }
+    template< typename T, uint32_t N > bool     empty   ( const small_array_t<T, N>& arr ) { return arr.size == 0; }
+    template< typename T, uint32_t N > bool     any     ( const small_array_t<T, N>& arr ) { return arr.size != 0; }
+    template< typename T, uint32_t N > T&       front   ( small_array_t<T, N>& arr )       { return arr.data[0]; }
+    template< typename T, uint32_t N > const T& front   ( const small_array_t<T, N>& arr ) { return arr.data[0]; }
+    template< typename T, uint32_t N > T&       back    ( small_array_t<T, N>& arr )       { return arr.data[arr.size - 1]; }
+    template< typename T, uint32_t N > const T& back    ( const small_array_t<T, N>& arr ) { return arr.data[arr.size - 1]; }
+
+    template< typename T, uint32_t N > void clear( small_array_t<T, N>& arr )
+    {
+        array_internal::destruct( arr.data, arr.size );
+        arr.size = 0;
+    }
+
+    // releases heap memory, array goes back to inline storage
+    template< typename T, uint32_t N > void destroy( small_array_t<T, N>& arr )
+    {
+        clear( arr );
+        if( !arr.is_inline() )
+        {
+            BX_FREE( arr.allocator, arr.data );
+            arr.data = (T*)arr._inline;
+            arr.capacity = N;
+        }
+    }
+
+    template< typename T, uint32_t N > void reserve( small_array_t<T, N>& arr, uint32_t new_capacity )
+    {
+        if( new_capacity > arr.capacity )
+            array_internal::_Grow( arr, new_capacity );
+    }
+
+    template< typename T, uint32_t N, typename... Targs > T& emplace_back( small_array_t<T, N>& arr, Targs&&... args )
+    {
+        if( arr.size == arr.capacity )
+        {
+            // new element is constructed before old ones move, so 'args' can reference element of this array
+            const uint32_t new_capacity = arr.capacity * 2;
+            T* new_data = (T*)BX_MALLOC( arr.allocator, sizeof( T ) * new_capacity, ALIGNOF( T ) );
+            new( new_data + arr.size ) T( std::forward<Targs>( args )... );
+
+            array_internal::relocate( new_data, arr.data, arr.size );
+            if( !arr.is_inline() )
+            {
+                BX_FREE( arr.allocator, arr.data );
+            }
+            arr.data = new_data;
+            arr.capacity = new_capacity;
+        }
+        else
+        {
+            new( arr.data + arr.size ) T( std::forward<Targs>( args )... );
+        }
+        return arr.data[arr.size++];
+    }
+
+    template< typename T, uint32_t N > uint32_t push_back( small_array_t<T, N>& arr, const T& value )
+    {
+        emplace_back( arr, value );
+        return arr.size - 1;
+    }
+
+    template< typename T, uint32_t N > void pop_back( small_array_t<T, N>& arr )
+    {
+        if( arr.size )
+        {
+            arr.data[--arr.size].~T();
+        }
+    }
+
+    template< typename T, uint32_t N > void erase_swap( small_array_t<T, N>& arr, uint32_t pos )
+    {
+        if( pos >= arr.size )
+            return;
+
+        if( pos != arr.size - 1 )
+        {
+            arr.data[pos] = std::move( back( arr ) );
+        }
+        pop_back( arr );
+    }
+
+    template< typename T, uint32_t N > void erase( small_array_t<T, N>& arr, uint32_t pos )
+    {
+        if( pos >= arr.size )
+            return;
+
+        for( uint32_t i = pos + 1; i < arr.size; ++i )
+        {
+            arr.data[i - 1] = std::move( arr.data[i] );
+        }
+        pop_back( arr );
+    }
+
+    // new elements are value initialized
+    template< typename T, uint32_t N > void resize( small_array_t<T, N>& arr, uint32_t new_size )
+    {
+        if( new_size > arr.capacity )
+            array_internal::_Grow( arr, new_size );
+
+        for( uint32_t i = arr.size; i < new_size; ++i )
+            new( arr.data + i ) T();
+
+        if( new_size < arr.size )
+            array_internal::destruct( arr.data + new_size, arr.size - new_size );
+
+        arr.size = new_size;
+    }
+
+    // new elements are left uninitialized. Only for types which don't need construction and destruction
+    template< typename T, uint32_t N > void resize_uninitialized( small_array_t<T, N>& arr, uint32_t new_size )
+    {
+        static_assert( std::is_trivially_default_constructible<T>::value && std::is_trivially_destructible<T>::value, "use resize" );
+        if( new_size > arr.capacity )
+            array_internal::_Grow( arr, new_size );
+
+        arr.size = new_size;
+    }
+}//
@@ -4,7 +4,7 @@
 
 namespace array
 {
-    template< typename T, uint32_t MAX > int      capacity( const static_array_t<T, MAX>& arr ) { return arr.capacity; }
+    template< typename T, uint32_t MAX > int      capacity( const static_array_t<T, MAX>& arr ) { return MAX; }
     template< typename T, uint32_t MAX > uint32_t size    ( const static_array_t<T, MAX>& arr ) { return arr.size; }
     template< typename T, uint32_t MAX > bool     empty   ( const static_array_t<T, MAX>& arr ) { return arr.size == 0; }
     template< typename T, uint32_t MAX > bool     any     ( const static_array_t<T, MAX>& arr ) { return arr.size != 0; }
@@ -64,6 +64,16 @@ namespace array
         SYS_ASSERT( newSize <= MAX );
         arr.size = newSize;
     }
+    // elements of static array are always constructed, so only size changes
+    template< typename T, uint32_t MAX > void resize_uninitialized( static_array_t<T, MAX>& arr, uint32_t newSize )
+    {
+        SYS_ASSERT( newSize <= MAX );
+        arr.size = newSize;
+    }
+    template< typename T, uint32_t MAX > void reserve( static_array_t<T, MAX>& arr, uint32_t newCapacity )
+    {
+        SYS_ASSERT( newCapacity <= MAX );
+    }
     template< typename T, uint32_t MAX > void resize( static_array_t<T, MAX>& arr, uint32_t newSize, const T& value )
     {
         SYS_ASSERT( newSize <= MAX );
@@ -0,0 +1,198 @@
+#include "string_interner.h"
+#include "containers.h"
+#include "hashmap.h"
+#include "hashed_string.h"
+#include "debug.h"
+#include "thread/rw_spin_lock.h"
+
+#include <memory/memory.h>
+#include <atomic>
+#include <string.h>
+
+namespace
+{
+    // Id is location of string: page index in high bits, offset in page (in ENTRY_ALIGNMENT units) in low bits.
+    // Page table has fixed size, so c_str() can read it while other thread adds pages.
+    static constexpr uint32_t PAGE_SIZE = 1u << 20;
+    static constexpr uint32_t ENTRY_ALIGNMENT = 8;
+    static constexpr uint32_t OFFSET_BITS = 17; // PAGE_SIZE / ENTRY_ALIGNMENT
+    static constexpr uint32_t OFFSET_MASK = (1u << OFFSET_BITS) - 1;
+    static constexpr uint32_t MAX_PAGES = 1024;
+    SYS_STATIC_ASSERT( (PAGE_SIZE / ENTRY_ALIGNMENT) == (1u << OFFSET_BITS) );
+
+    // string follows header
+    struct Entry
+    {
+        uint64_t hash;
+        uint32_t length;
+        uint32_t padding;
+    };
+
+    struct Interner
+    {
+        rw_spin_lock_t lock;
+        hash_t<uint32_t> lookup; // multi hash. key: string hash, value: id
+        std::atomic<uint8_t*> pages[MAX_PAGES] = {};
+        uint32_t nb_pages = 0;
+        uint32_t page_offset = 0; // write position in last page
+        uint32_t nb_strings = 0;
+        uint64_t bytes_used = 0;
+        BXIAllocator* allocator = nullptr;
+
+        Interner( BXIAllocator* a )
+            : lookup( a ), allocator( a )
+        {}
+    };
+    static Interner* _interner = nullptr;
+
+    static inline const Entry* GetEntry( uint32_t id )
+    {
+        const uint8_t* page = _interner->pages[id >> OFFSET_BITS].load( std::memory_order_acquire );
+        return (const Entry*)(page + (id & OFFSET_MASK) * ENTRY_ALIGNMENT);
+    }
+
+    static inline bool Equals( const Entry* e, uint64_t hash, const char* str, uint32_t length )
+    {
+        return e->hash == hash && e->length == length && memcmp( e + 1, str, length ) == 0;
+    }
+
+    static uint32_t FindLocked( uint64_t hash, const char* str, uint32_t length )
+    {
+        const hash_t<uint32_t>::Entry* it = multi_hash::find_first( _interner->lookup, hash );
+        while( it )
+        {
+            if( Equals( GetEntry( it->value ), hash, str, length ) )
+                return it->value;
+
+            it = multi_hash::find_next( _interner->lookup, it );
+        }
+        return 0;
+    }
+
+    static uint32_t AddLocked( uint64_t hash, const char* str, uint32_t length )
+    {
+        Interner* si = _interner;
+
+        const uint32_t entry_size = (uint32_t)TYPE_ALIGN( sizeof( Entry ) + length + 1, ENTRY_ALIGNMENT );
+        SYS_ASSERT_TXT( entry_size <= PAGE_SIZE, "string is too long to be interned" );
+
+        if( si->nb_pages == 0 || si->page_offset + entry_size > PAGE_SIZE )
+        {
+            SYS_ASSERT_TXT( si->nb_pages < MAX_PAGES, "string interner is full" );
+            uint8_t* page = (uint8_t*)BX_MALLOC( si->allocator, PAGE_SIZE, ENTRY_ALIGNMENT );
+            si->pages[si->nb_pages++].store( page, std::memory_order_release );
+            si->page_offset = 0;
+        }
+
+        const uint32_t page_index = si->nb_pages - 1;
+        uint8_t* page = si->pages[page_index].load( std::memory_order_relaxed );
+        Entry* e = (Entry*)(page + si->page_offset);
+        e->hash = hash;
+        e->length = length;
+        e->padding = 0;
+        memcpy( e + 1, str, length );
+        ((char*)(e + 1))[length] = 0;
+
+        const uint32_t id = (page_index << OFFSET_BITS) | (si->page_offset / ENTRY_ALIGNMENT);
+        si->page_offset += entry_size;
+        si->bytes_used += entry_size;
+        si->nb_strings += 1;
+
+        multi_hash::insert( si->lookup, hash, id );
+        return id;
+    }
+}//
+
+namespace string_interner
+{
+    void StartUp( BXIAllocator* allocator )
+    {
+        SYS_ASSERT( _interner == nullptr );
+        _interner = BX_NEW( allocator, Interner, allocator );
+
+        // empty string goes first, so it gets id 0
+        scoped_write_spin_lock_t guard( _interner->lock );
+        AddLocked( hashed_string( "", 0 ), "", 0 );
+    }
+
+    void ShutDown()
+    {
+        if( !_interner )
+            return;
+
+        BXIAllocator* allocator = _interner->allocator;
+        for( uint32_t i = 0; i < _interner->nb_pages; ++i )
+        {
+            uint8_t* page = _interner->pages[i].load( std::memory_order_relaxed );
+            BX_FREE( allocator, page );
+        }
+        BX_DELETE0( allocator, _interner );
+    }
+
+    interned_string_t intern( const char* str, uint32_t length )
+    {
+        if( !str || length == 0 )
+            return {};
+
+        const uint64_t hash = hashed_string( str, length );
+
+        interned_string_t result;
+        {
+            scoped_read_spin_lock_t guard( _interner->lock );
+            result.id = FindLocked( hash, str, length );
+        }
+        if( result.id )
+            return result;
+
+        // other thread could add the same string in the meantime
+        scoped_write_spin_lock_t guard( _interner->lock );
+        result.id = FindLocked( hash, str, length );
+        if( !result.id )
+        {
+            result.id = AddLocked( hash, str, length );
+        }
+        return result;
+    }
+
+    interned_string_t intern( const char* str )
+    {
+        return intern( str, (str) ? (uint32_t)strlen( str ) : 0 );
+    }
+
+    interned_string_t find( const char* str )
+    {
+        interned_string_t result;
+        if( !str || !str[0] )
+            return result;
+
+        const uint32_t length = (uint32_t)strlen( str );
+        scoped_read_spin_lock_t guard( _interner->lock );
+        result.id = FindLocked( hashed_string( str, length ), str, length );
+        return result;
+    }
+
+    const char* c_str( interned_string_t s )
+    {
+        return (const char*)(GetEntry( s.id ) + 1);
+    }
+
+    uint32_t length( interned_string_t s )
+    {
+        return GetEntry( s.id )->length;
+    }
+
+    uint64_t hash( interned_string_t s )
+    {
+        return GetEntry( s.id )->hash;
+    }
+
+    stats_t stats()
+    {
+        scoped_read_spin_lock_t guard( _interner->lock );
+        stats_t result;
+        result.nb_strings = _interner->nb_strings;
+        result.nb_pages = _interner->nb_pages;
+        result.bytes_used = _interner->bytes_used;
+        return result;
+    }
+}//
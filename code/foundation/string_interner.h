@@ -0,0 +1,48 @@
+#pragma once
+
+#include "type.h"
+
+struct BXIAllocator;
+
+// Id of string stored once in global string interner. Equal strings always have equal ids,
+// so comparing strings is comparing integers. Id 0 is empty string.
+struct interned_string_t
+{
+    uint32_t id = 0;
+
+    const char* c_str() const;
+    uint32_t    length() const;
+    bool        empty() const { return id == 0; }
+};
+inline bool operator == ( interned_string_t a, interned_string_t b ) { return a.id == b.id; }
+inline bool operator != ( interned_string_t a, interned_string_t b ) { return a.id != b.id; }
+
+// Strings are appended to pages and never freed, so it's meant for names which live for whole session
+// (resource paths, asset names). Thread safe. c_str() doesn't take any lock.
+namespace string_interner
+{
+    void StartUp( BXIAllocator* allocator );
+    void ShutDown();
+
+    // returns existing id when string is already interned
+    interned_string_t intern( const char* str );
+    interned_string_t intern( const char* str, uint32_t length );
+
+    // doesn't add string. Returns empty id when string is not interned
+    interned_string_t find( const char* str );
+
+    const char* c_str ( interned_string_t s );
+    uint32_t    length( interned_string_t s );
+    uint64_t    hash  ( interned_string_t s ); // the same as hashed_string( s.c_str() )
+
+    struct stats_t
+    {
+        uint32_t nb_strings;
+        uint32_t nb_pages;
+        uint64_t bytes_used; // including headers
+    };
+    stats_t stats();
+}//
+
+inline const char* interned_string_t::c_str() const { return string_interner::c_str( *this ); }
+inline uint32_t    interned_string_t::length() const { return string_interner::length( *this ); }
@@ -6,8 +6,15 @@
 
 union tag32_t
 {
-	tag32_t() : _tag(0) {}
-	explicit tag32_t( const char tag[5] )	{ _tag = *((uint32_t*)tag); }
+	constexpr tag32_t() : _tag(0) {}
+	// constexpr, so tag of literal is folded by compiler. Bytes after terminator are zero
+	constexpr explicit tag32_t( const char tag[5] )
+		: _tag( ( !tag[0] ) ? 0 :
+		        ( !tag[1] ) ? (uint32_t)(uint8_t)tag[0] :
+		        ( !tag[2] ) ? (uint32_t)(uint8_t)tag[0] | (uint32_t)(uint8_t)tag[1] << 8 :
+		        ( !tag[3] ) ? (uint32_t)(uint8_t)tag[0] | (uint32_t)(uint8_t)tag[1] << 8 | (uint32_t)(uint8_t)tag[2] << 16 :
+		        (uint32_t)(uint8_t)tag[0] | (uint32_t)(uint8_t)tag[1] << 8 | (uint32_t)(uint8_t)tag[2] << 16 | (uint32_t)(uint8_t)tag[3] << 24 )
+	{}
 		
     uint32_t _tag;
 	struct
@@ -18,7 +25,7 @@ union tag32_t
 		uint8_t _byte4;
 	};
 	
-	operator const uint32_t() const { return _tag; }
+	constexpr operator const uint32_t() const { return _tag; }
 };
 
 union Tag32ToString
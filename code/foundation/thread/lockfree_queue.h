@@ -0,0 +1,292 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <new>
+
+#include "../debug.h"
+#include <memory/memory.h>
+
+static constexpr uint32_t BX_CACHE_LINE_SIZE = 64;
+
+// Items are copied with assignment, so T should be small and trivially copyable.
+// Producer and consumer indices live on separate cache lines, so threads on both ends don't fight over one line.
+
+//--- bounded single producer / single consumer ring. Capacity is rounded up to power of two
+template< typename T >
+class spsc_queue_t
+{
+public:
+    spsc_queue_t() = default;
+    ~spsc_queue_t() { destroy(); }
+
+    void create( uint32_t capacity, BXIAllocator* allocator )
+    {
+        SYS_ASSERT( _data == nullptr );
+        uint32_t size = 2;
+        while( size < capacity )
+            size *= 2;
+
+        _data = (T*)BX_MALLOC( allocator, size * sizeof( T ), ALIGNOF( T ) );
+        _mask = size - 1;
+        _allocator = allocator;
+    }
+    void destroy()
+    {
+        BX_FREE0( _allocator, _data );
+    }
+
+    // producer only. Returns number of pushed items (less than 'count' when queue is full)
+    uint32_t push( const T* items, uint32_t count )
+    {
+        const uint32_t tail = _tail.load( std::memory_order_relaxed );
+        if( tail - _head_cache + count > _mask + 1 )
+        {
+            _head_cache = _head.load( std::memory_order_acquire );
+        }
+        const uint32_t space = _mask + 1 - (tail - _head_cache);
+        const uint32_t n = (count < space) ? count : space;
+        for( uint32_t i = 0; i < n; ++i )
+        {
+            _data[(tail + i) & _mask] = items[i];
+        }
+        _tail.store( tail + n, std::memory_order_release );
+        return n;
+    }
+    bool push( const T& item ) { return push( &item, 1 ) == 1; }
+
+    // consumer only. Returns number of popped items
+    uint32_t pop( T* items, uint32_t max_count )
+    {
+        const uint32_t head = _head.load( std::memory_order_relaxed );
+        if( _tail_cache - head < max_count )
+        {
+            _tail_cache = _tail.load( std::memory_order_acquire );
+        }
+        const uint32_t available = _tail_cache - head;
+        const uint32_t n = (max_count < available) ? max_count : available;
+        for( uint32_t i = 0; i < n; ++i )
+        {
+            items[i] = _data[(head + i) & _mask];
+        }
+        _head.store( head + n, std::memory_order_release );
+        return n;
+    }
+    bool pop( T* item ) { return pop( item, 1 ) == 1; }
+
+    // approximate when called concurrently
+    uint32_t size() const { return _tail.load( std::memory_order_acquire ) - _head.load( std::memory_order_acquire ); }
+
+private:
+    spsc_queue_t( const spsc_queue_t& ) = delete;
+    spsc_queue_t& operator = ( const spsc_queue_t& ) = delete;
+
+    alignas( BX_CACHE_LINE_SIZE ) std::atomic_uint32_t _head = 0; // written by consumer
+    uint32_t _tail_cache = 0;
+    alignas( BX_CACHE_LINE_SIZE ) std::atomic_uint32_t _tail = 0; // written by producer
+    uint32_t _head_cache = 0;
+    alignas( BX_CACHE_LINE_SIZE ) T* _data = nullptr;
+    uint32_t _mask = 0;
+    BXIAllocator* _allocator = nullptr;
+};
+
+//--- bounded multi producer / multi consumer ring (D. Vyukov). Capacity is rounded up to power of two.
+// Each cell has sequence number which tells whether it's ready for producer or consumer, so threads only
+// contend on index they claim with compare-exchange
+template< typename T >
+class mpmc_queue_t
+{
+public:
+    mpmc_queue_t() = default;
+    ~mpmc_queue_t() { destroy(); }
+
+    void create( uint32_t capacity, BXIAllocator* allocator )
+    {
+        SYS_ASSERT( _cells == nullptr );
+        uint32_t size = 2;
+        while( size < capacity )
+            size *= 2;
+
+        _cells = (Cell*)BX_MALLOC( allocator, size * sizeof( Cell ), ALIGNOF( Cell ) );
+        for( uint32_t i = 0; i < size; ++i )
+        {
+            new (&_cells[i].sequence) std::atomic_uint32_t( i );
+        }
+        _mask = size - 1;
+        _allocator = allocator;
+    }
+    void destroy()
+    {
+        BX_FREE0( _allocator, _cells );
+    }
+
+    // returns false when queue is full
+    bool push( const T& item )
+    {
+        uint32_t pos = _tail.load( std::memory_order_relaxed );
+        for( ;; )
+        {
+            Cell& cell = _cells[pos & _mask];
+            const uint32_t seq = cell.sequence.load( std::memory_order_acquire );
+            const int32_t diff = (int32_t)(seq - pos);
+            if( diff == 0 )
+            {
+                if( _tail.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+                {
+                    cell.data = item;
+                    cell.sequence.store( pos + 1, std::memory_order_release );
+                    return true;
+                }
+            }
+            else if( diff < 0 )
+            {
+                return false;
+            }
+            else
+            {
+                pos = _tail.load( std::memory_order_relaxed );
+            }
+        }
+    }
+
+    // returns false when queue is empty
+    bool pop( T* item )
+    {
+        uint32_t pos = _head.load( std::memory_order_relaxed );
+        for( ;; )
+        {
+            Cell& cell = _cells[pos & _mask];
+            const uint32_t seq = cell.sequence.load( std::memory_order_acquire );
+            const int32_t diff = (int32_t)(seq - (pos + 1));
+            if( diff == 0 )
+            {
+                if( _head.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+                {
+                    item[0] = cell.data;
+                    cell.sequence.store( pos + _mask + 1, std::memory_order_release );
+                    return true;
+                }
+            }
+            else if( diff < 0 )
+            {
+                return false;
+            }
+            else
+            {
+                pos = _head.load( std::memory_order_relaxed );
+            }
+        }
+    }
+
+    // Returns number of pushed / popped items. Items are claimed one by one, so batch isn't atomic
+    uint32_t push( const T* items, uint32_t count )
+    {
+        uint32_t n = 0;
+        while( n < count && push( items[n] ) )
+            ++n;
+        return n;
+    }
+    uint32_t pop( T* items, uint32_t max_count )
+    {
+        uint32_t n = 0;
+        while( n < max_count && pop( &items[n] ) )
+            ++n;
+        return n;
+    }
+
+    // approximate when called concurrently
+    uint32_t size() const { return _tail.load( std::memory_order_acquire ) - _head.load( std::memory_order_acquire ); }
+
+private:
+    mpmc_queue_t( const mpmc_queue_t& ) = delete;
+    mpmc_queue_t& operator = ( const mpmc_queue_t& ) = delete;
+
+    struct Cell
+    {
+        std::atomic_uint32_t sequence;
+        T data;
+    };
+
+    alignas( BX_CACHE_LINE_SIZE ) std::atomic_uint32_t _tail = 0;
+    alignas( BX_CACHE_LINE_SIZE ) std::atomic_uint32_t _head = 0;
+    alignas( BX_CACHE_LINE_SIZE ) Cell* _cells = nullptr;
+    uint32_t _mask = 0;
+    BXIAllocator* _allocator = nullptr;
+};
+
+//--- unbounded intrusive multi producer / single consumer queue (D. Vyukov).
+// Node has to be the first member of item and stay alive until it's popped. Push is wait free.
+struct mpsc_node_t
+{
+    std::atomic<mpsc_node_t*> next = nullptr;
+};
+
+class mpsc_queue_t
+{
+public:
+    mpsc_queue_t()
+        : _head( &_stub ), _tail( &_stub )
+    {}
+
+    // 'first' .. 'last' have to be already linked with 'next'. Whole chain is published with one exchange
+    void push( mpsc_node_t* first, mpsc_node_t* last )
+    {
+        last->next.store( nullptr, std::memory_order_relaxed );
+        mpsc_node_t* prev = _head.exchange( last, std::memory_order_acq_rel );
+        prev->next.store( first, std::memory_order_release );
+    }
+    void push( mpsc_node_t* node ) { push( node, node ); }
+
+    // consumer only. Returns nullptr when queue is empty, or when producer is in the middle of push
+    // (it's visible again as soon as push returns)
+    mpsc_node_t* pop()
+    {
+        mpsc_node_t* tail = _tail;
+        mpsc_node_t* next = tail->next.load( std::memory_order_acquire );
+        if( tail == &_stub )
+        {
+            if( !next )
+                return nullptr;
+
+            _tail = next;
+            tail = next;
+            next = next->next.load( std::memory_order_acquire );
+        }
+
+        if( next )
+        {
+            _tail = next;
+            return tail;
+        }
+
+        if( tail != _head.load( std::memory_order_acquire ) )
+            return nullptr;
+
+        // last node can be returned only when stub is queued behind it
+        push( &_stub );
+        next = tail->next.load( std::memory_order_acquire );
+        if( next )
+        {
+            _tail = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    // consumer only. Returns number of popped nodes
+    uint32_t pop( mpsc_node_t** nodes, uint32_t max_count )
+    {
+        uint32_t n = 0;
+        while( n < max_count && (nodes[n] = pop()) != nullptr )
+            ++n;
+        return n;
+    }
+
+private:
+    mpsc_queue_t( const mpsc_queue_t& ) = delete;
+    mpsc_queue_t& operator = ( const mpsc_queue_t& ) = delete;
+
+    alignas( BX_CACHE_LINE_SIZE ) std::atomic<mpsc_node_t*> _head; // written by producers
+    alignas( BX_CACHE_LINE_SIZE ) mpsc_node_t* _tail;              // touched only by consumer
+    mpsc_node_t _stub;
+};
@@ -0,0 +1,547 @@
+#include <memory/memory.h>
+
+#include <foundation/type.h>
+#include <foundation/time.h>
+#include <foundation/common.h>
+#include <foundation/containers.h>
+#include <foundation/array.h>
+#include <foundation/queue.h>
+#include <foundation/hashmap.h>
+#include <foundation/id_table.h>
+#include <foundation/id_array.h>
+#include <foundation/slot_map.h>
+#include <foundation/bitset.h>
+#include <foundation/string_util.h>
+#include <foundation/hash.h>
+#include <foundation/hashed_string.h>
+#include <foundation/container_allocator.h>
+
+#include <foundation/EASTL/hash_map.h>
+#include <foundation/EASTL/vector.h>
+
+#include <stdio.h>
+#include <string.h>
+
+// Baseline numbers for foundation containers and hashes. Each case runs a few times and the best run is reported,
+// so numbers from before and after container changes can be compared directly.
+
+static constexpr uint32_t NB_RUNS = 5;
+
+static volatile uint64_t _sink = 0; // keeps results alive, so loops are not optimized away
+
+static inline uint64_t Mix( uint64_t x )
+{
+    x ^= x >> 31;
+    x *= 0x7fb5d329728ea185ULL;
+    x ^= x >> 27;
+    return x;
+}
+
+struct Bench
+{
+    const char* name;
+    uint32_t n;
+    uint64_t nb_ops;
+    uint64_t best_us;
+};
+
+static void Report( const Bench& b )
+{
+    const double ns_per_op = (b.nb_ops) ? (double)b.best_us * 1000.0 / (double)b.nb_ops : 0.0;
+    printf( "%-48s n: %8u  %10.2f ns/op  (%llu us)\n", b.name, b.n, ns_per_op, b.best_us );
+}
+
+// 'func' returns number of operations it has done
+template< typename Tfunc >
+static void Run( const char* name, uint32_t n, Tfunc func )
+{
+    Bench b = { name, n, 0, UINT64_MAX };
+    for( uint32_t run = 0; run < NB_RUNS; ++run )
+    {
+        BXTimeQuery tq = BXTimeQuery::Begin();
+        const uint64_t nb_ops = func();
+        BXTimeQuery::End( &tq );
+
+        b.nb_ops = nb_ops;
+        b.best_us = min_of_2( b.best_us, tq.duration_US );
+    }
+    Report( b );
+}
+
+// --- hash maps
+using EAHashMap = eastl::hash_map<uint64_t, uint32_t, eastl::hash<uint64_t>, eastl::equal_to<uint64_t>, bx_container_allocator>;
+using EAVector = eastl::vector<uint32_t, bx_container_allocator>;
+
+static void BenchHashMap( BXIAllocator* allocator, uint32_t n )
+{
+    Run( "hash_t insert", n, [=]()
+    {
+        hash_t<uint32_t> h( allocator );
+        for( uint32_t i = 0; i < n; ++i )
+            hash::set( h, Mix( i ), i );
+        return (uint64_t)n;
+    } );
+    Run( "eastl::hash_map insert", n, [=]()
+    {
+        EAHashMap h;
+        for( uint32_t i = 0; i < n; ++i )
+            h[Mix( i )] = i;
+        return (uint64_t)n;
+    } );
+
+    hash_t<uint32_t> h( allocator );
+    EAHashMap eh;
+    for( uint32_t i = 0; i < n; ++i )
+    {
+        hash::set( h, Mix( i ), i );
+        eh[Mix( i )] = i;
+    }
+
+    Run( "hash_t lookup hit", n, [&]()
+    {
+        uint64_t sum = 0;
+        for( uint32_t i = 0; i < n; ++i )
+            sum += hash::get( h, Mix( i ), 0u );
+        _sink += sum;
+        return (uint64_t)n;
+    } );
+    Run( "eastl::hash_map lookup hit", n, [&]()
+    {
+        uint64_t sum = 0;
+        for( uint32_t i = 0; i < n; ++i )
+            sum += eh.find( Mix( i ) )->second;
+        _sink += sum;
+        return (uint64_t)n;
+    } );
+    Run( "hash_t lookup miss", n, [&]()
+    {
+        uint64_t sum = 0;
+        for( uint32_t i = 0; i < n; ++i )
+            sum += hash::has( h, Mix( i + n ) );
+        _sink += sum;
+        return (uint64_t)n;
+    } );
+    Run( "eastl::hash_map lookup miss", n, [&]()
+    {
+        uint64_t sum = 0;
+        for( uint32_t i = 0; i < n; ++i )
+            sum += eh.find( Mix( i + n ) ) != eh.end();
+        _sink += sum;
+        return (uint64_t)n;
+    } );
+
+    // removes half of entries and puts them back, so size stays the same between runs
+    Run( "hash_t remove + insert", n, [&]()
+    {
+        for( uint32_t i = 0; i < n; i += 2 )
+            hash::remove( h, Mix( i ) );
+        for( uint32_t i = 0; i < n; i += 2 )
+            hash::set( h, Mix( i ), i );
+        return (uint64_t)n;
+    } );
+    Run( "eastl::hash_map remove + insert", n, [&]()
+    {
+        for( uint32_t i = 0; i < n; i += 2 )
+            eh.erase( Mix( i ) );
+        for( uint32_t i = 0; i < n; i += 2 )
+            eh[Mix( i )] = i;
+        return (uint64_t)n;
+    } );
+}
+
+// lookups in table of fixed size filled to given fraction of its slots
+static void BenchHashMapLoadFactor( BXIAllocator* allocator, uint32_t capacity )
+{
+    static const uint32_t LOAD_PERCENT[] = { 25, 50, 75, 85 };
+    for( uint32_t load_percent : LOAD_PERCENT )
+    {
+        hash_t<uint32_t> h( allocator );
+        hash::reserve( h, capacity * 7 / 8 );
+        const uint32_t n = h._capacity * load_percent / 100;
+        for( uint32_t i = 0; i < n; ++i )
+            hash::set( h, Mix( i ), i );
+
+        char name[64];
+        snprintf( name, sizeof( name ), "hash_t lookup hit  (load %u%%)", load_percent );
+        Run( name, n, [&]()
+        {
+            uint64_t sum = 0;
+            for( uint32_t i = 0; i < n; ++i )
+                sum += hash::get( h, Mix( i ), 0u );
+            _sink += sum;
+            return (uint64_t)n;
+        } );
+        snprintf( name, sizeof( name ), "hash_t lookup miss (load %u%%)", load_percent );
+        Run( name, n, [&]()
+        {
+            uint64_t sum = 0;
+            for( uint32_t i = 0; i < n; ++i )
+                sum += hash::has( h, Mix( i + n ) );
+            _sink += sum;
+            return (uint64_t)n;
+        } );
+    }
+}
+
+// --- arrays and queues
+static void BenchArray( BXIAllocator* allocator, uint32_t n )
+{
+    Run( "array_t push_back (growing)", n, [=]()
+    {
+        array_t<uint32_t> a( allocator );
+        for( uint32_t i = 0; i < n; ++i )
+            array::push_back( a, i );
+        _sink += a[n - 1];
+        return (uint64_t)n;
+    } );
+    Run( "eastl::vector push_back (growing)", n, [=]()
+    {
+        EAVector v;
+        for( uint32_t i = 0; i < n; ++i )
+            v.push_back( i );
+        _sink += v[n - 1];
+        return (uint64_t)n;
+    } );
+    Run( "queue_t push_back + pop_front", n, [=]()
+    {
+        queue_t<uint32_t> q( allocator );
+        uint64_t sum = 0;
+        for( uint32_t i = 0; i < n; ++i )
+        {
+            queue::push_back( q, i );
+            if( queue::size( q ) > 64 )
+            {
+                sum += queue::front( q );
+                queue::pop_front( q );
+            }
+        }
+        _sink += sum;
+        return (uint64_t)n;
+    } );
+}
+
+// --- id tables
+static constexpr uint32_t ID_CAPACITY = 4096;
+static id_table_t<ID_CAPACITY> _id_table;
+static id_array_t<ID_CAPACITY> _id_array;
+
+static void BenchIds( uint32_t n )
+{
+    Run( "id_table create/destroy churn", n, [=]()
+    {
+        id_t ids[ID_CAPACITY];
+        uint32_t count = 0;
+        for( uint32_t i = 0; i < n; ++i )
+        {
+            // keeps table half full, destroying pseudo random ids
+            if( count < ID_CAPACITY / 2 )
+            {
+                ids[count++] = id_table::create( _id_table );
+            }
+            else
+            {
+                const uint32_t index = (uint32_t)Mix( i ) % count;
+                id_table::destroy( _id_table, ids[index] );
+                ids[index] = ids[--count];
+            }
+        }
+        for( uint32_t i = 0; i < count; ++i )
+            id_table::destroy( _id_table, ids[i] );
+        return (uint64_t)n;
+    } );
+    Run( "id_array create/destroy churn", n, [=]()
+    {
+        id_t ids[ID_CAPACITY];
+        uint32_t count = 0;
+        for( uint32_t i = 0; i < n; ++i )
+        {
+            if( count < ID_CAPACITY / 2 )
+            {
+                ids[count++] = id_array::create( _id_array );
+            }
+            else
+            {
+                const uint32_t index = (uint32_t)Mix( i ) % count;
+                id_array::destroy( _id_array, ids[index] );
+                ids[index] = ids[--count];
+            }
+        }
+        for( uint32_t i = 0; i < count; ++i )
+            id_array::destroy( _id_array, ids[i] );
+        return (uint64_t)n;
+    } );
+    Run( "slot_map create/destroy churn", n, [=]()
+    {
+        slot_map_t<slot_id_t> map;
+        slot_id_t ids[ID_CAPACITY];
+        uint32_t count = 0;
+        for( uint32_t i = 0; i < n; ++i )
+        {
+            if( count < ID_CAPACITY / 2 )
+            {
+                ids[count++] = slot_map::create( map );
+            }
+            else
+            {
+                const uint32_t index = (uint32_t)Mix( i ) % count;
+                slot_map::destroy( map, ids[index] );
+                ids[index] = ids[--count];
+            }
+        }
+        return (uint64_t)n;
+    } );
+}
+
+// slot map beyond 64K entries id_table and id_array can hold
+static void BenchSlotMap( BXIAllocator* allocator, uint32_t n )
+{
+    slot_map_t<slot_id_t> map( allocator );
+    array_t<slot_id_t> ids( allocator );
+    array::reserve( ids, (int)n );
+
+    Run( "slot_map create + destroy_all", n, [&]()
+    {
+        array::clear( ids );
+        for( uint32_t i = 0; i < n; ++i )
+            array::push_back( ids, slot_map::create( map ) );
+        slot_map::destroy_all( map );
+        return (uint64_t)n;
+    } );
+
+    for( uint32_t i = 0; i < n; ++i )
+        ids[i] = slot_map::create( map );
+
+    Run( "slot_map lookup", n, [&]()
+    {
+        uint64_t sum = 0;
+        for( uint32_t i = 0; i < n; ++i )
+            sum += slot_map::index( map, ids[(uint32_t)Mix( i ) % n] );
+        _sink += sum;
+        return (uint64_t)n;
+    } );
+}
+
+// --- bitsets
+static void BenchBitset( BXIAllocator* allocator, uint32_t nb_bits )
+{
+    hbitset_t a, b, dst;
+    hbitset::create( a, nb_bits, allocator );
+    hbitset::create( b, nb_bits, allocator );
+    hbitset::create( dst, nb_bits, allocator );
+    for( uint32_t i = 0; i < nb_bits; ++i )
+    {
+        if( Mix( i ) & 1 )
+            hbitset::set( a, i );
+        if( Mix( i + nb_bits ) & 1 )
+            hbitset::set( b, i );
+    }
+
+    Run( "hbitset op_and + population", nb_bits, [&]()
+    {
+        hbitset::op_and( dst, a, b );
+        _sink += hbitset::population( dst );
+        return (uint64_t)nb_bits;
+    } );
+    Run( "hbitset for_each_set", nb_bits, [&]()
+    {
+        uint64_t sum = 0;
+        hbitset::for_each_set( a, [&sum]( uint32_t i ) { sum += i; } );
+        _sink += sum;
+        return (uint64_t)nb_bits;
+    } );
+
+    // slot allocator usage: almost full set, free slot is found and taken, then released again
+    hbitset::set_all( dst );
+    Run( "hbitset find_first_clear + set (almost full)", nb_bits, [&]()
+    {
+        const uint32_t n = 64 * 1024;
+        for( uint32_t i = 0; i < n; ++i )
+        {
+            const uint32_t slot = (uint32_t)Mix( i ) % nb_bits;
+            hbitset::clear( dst, slot );
+            const uint32_t found = hbitset::find_first_clear( dst );
+            hbitset::set( dst, found );
+        }
+        return (uint64_t)n;
+    } );
+}
+
+// --- strings and hashes
+static void BenchStrings( BXIAllocator* allocator, const char* str, const char* label, uint32_t n )
+{
+    char name[64];
+    const uint32_t len = (uint32_t)strlen( str );
+
+    snprintf( name, sizeof( name ), "string_t create + free (%s)", label );
+    Run( name, n, [=]()
+    {
+        for( uint32_t i = 0; i < n; ++i )
+        {
+            string_t s;
+            string::create( &s, str, allocator );
+            _sink += s.c_str()[0];
+            string::free( &s );
+        }
+        return (uint64_t)n;
+    } );
+
+    snprintf( name, sizeof( name ), "string_t copy (%s)", label );
+    Run( name, n, [=]()
+    {
+        string_t src;
+        string::create( &src, str, allocator );
+        for( uint32_t i = 0; i < n; ++i )
+        {
+            string_t dst;
+            string::copy( &dst, src );
+            _sink += dst.c_str()[0];
+            string::free( &dst );
+        }
+        string::free( &src );
+        return (uint64_t)n;
+    } );
+
+    snprintf( name, sizeof( name ), "murmur3_hash32 (%s)", label );
+    Run( name, n, [=]()
+    {
+        uint64_t sum = 0;
+        for( uint32_t i = 0; i < n; ++i )
+            sum += murmur3_hash32( str, len, i );
+        _sink += sum;
+        return (uint64_t)n;
+    } );
+
+    snprintf( name, sizeof( name ), "crc32n (%s)", label );
+    Run( name, n, [=]()
+    {
+        uint64_t sum = 0;
+        for( uint32_t i = 0; i < n; ++i )
+            sum += crc32n( (const unsigned char*)str, len, i );
+        _sink += sum;
+        return (uint64_t)n;
+    } );
+
+    snprintf( name, sizeof( name ), "crc32c (%s)", label );
+    Run( name, n, [=]()
+    {
+        uint64_t sum = 0;
+        for( uint32_t i = 0; i < n; ++i )
+            sum += crc32c( str, len, i );
+        _sink += sum;
+        return (uint64_t)n;
+    } );
+
+    snprintf( name, sizeof( name ), "xxhash64 (%s)", label );
+    Run( name, n, [=]()
+    {
+        uint64_t sum = 0;
+        for( uint32_t i = 0; i < n; ++i )
+            sum += xxhash64( str, len, i );
+        _sink += sum;
+        return (uint64_t)n;
+    } );
+
+    snprintf( name, sizeof( name ), "hashed_string (%s)", label );
+    Run( name, n, [=]()
+    {
+        uint64_t sum = 0;
+        for( uint32_t i = 0; i < n; ++i )
+            sum += hashed_string( str );
+        _sink += sum;
+        return (uint64_t)n;
+    } );
+}
+
+// --- content hashing. Reported per byte
+static void BenchContentHash( BXIAllocator* allocator, uint32_t size, uint32_t n )
+{
+    uint8_t* data = (uint8_t*)BX_MALLOC( allocator, size, 16 );
+    for( uint32_t i = 0; i < size; ++i )
+        data[i] = (uint8_t)Mix( i );
+
+    char name[64];
+    snprintf( name, sizeof( name ), "murmur3_hash32 (%u KB)", size / 1024 );
+    Run( name, n, [=]()
+    {
+        uint64_t sum = 0;
+        for( uint32_t i = 0; i < n; ++i )
+            sum += murmur3_hash32( data, size, i );
+        _sink += sum;
+        return (uint64_t)n * size;
+    } );
+
+    snprintf( name, sizeof( name ), "crc32n (%u KB)", size / 1024 );
+    Run( name, n, [=]()
+    {
+        uint64_t sum = 0;
+        for( uint32_t i = 0; i < n; ++i )
+            sum += crc32n( data, size, i );
+        _sink += sum;
+        return (uint64_t)n * size;
+    } );
+
+    snprintf( name, sizeof( name ), "crc32c (%u KB)", size / 1024 );
+    Run( name, n, [=]()
+    {
+        uint64_t sum = 0;
+        for( uint32_t i = 0; i < n; ++i )
+            sum += crc32c( data, size, i );
+        _sink += sum;
+        return (uint64_t)n * size;
+    } );
+
+    snprintf( name, sizeof( name ), "xxhash64 (%u KB)", size / 1024 );
+    Run( name, n, [=]()
+    {
+        uint64_t sum = 0;
+        for( uint32_t i = 0; i < n; ++i )
+            sum += xxhash64( data, size, i );
+        _sink += sum;
+        return (uint64_t)n * size;
+    } );
+
+    BX_FREE( allocator, data );
+}
+
+int main( int argc, const char** argv )
+{
+    BXMemoryStartUp();
+    BXIAllocator* allocator = BXDefaultAllocator();
+
+    printf( "--- hash maps\n" );
+    BenchHashMap( allocator, 1024 );
+    BenchHashMap( allocator, 64 * 1024 );
+    BenchHashMap( allocator, 1024 * 1024 );
+
+    printf( "--- hash_t load factor\n" );
+    BenchHashMapLoadFactor( allocator, 64 * 1024 );
+
+    printf( "--- arrays\n" );
+    BenchArray( allocator, 1024 );
+    BenchArray( allocator, 1024 * 1024 );
+
+    printf( "--- ids\n" );
+    BenchIds( 1024 * 1024 );
+    BenchSlotMap( allocator, 1024 * 1024 );
+
+    printf( "--- bitsets\n" );
+    BenchBitset( allocator, 4 * 1024 * 1024 );
+
+    printf( "--- strings and hashes\n" );
+    char long_str[1024];
+    for( uint32_t i = 0; i < sizeof( long_str ) - 1; ++i )
+        long_str[i] = 'a' + (char)(Mix( i ) % 26);
+    long_str[sizeof( long_str ) - 1] = 0;
+
+    BenchStrings( allocator, "mesh/box.mesh", "short", 1024 * 1024 );
+    BenchStrings( allocator, long_str, "long", 64 * 1024 );
+
+    printf( "--- content hashing (ns/byte)\n" );
+    BenchContentHash( allocator, 64 * 1024, 256 );
+    BenchContentHash( allocator, 16 * 1024 * 1024, 4 );
+
+    printf( "sink: %llu\n", (uint64_t)_sink );
+
+    BXMemoryShutDown();
+    return 0;
+}
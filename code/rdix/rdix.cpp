@@ -309,9 +309,8 @@ RDIXResourceBinding* CloneResourceBinding( const RDIXResourceBinding* binding, B
 
 namespace
 {
-	static inline uint32_t _FindBinding( RDIXResourceBinding* binding, const char* name )
+	static inline uint32_t _FindBinding( RDIXResourceBinding* binding, uint32_t hashed_name )
 	{
-		const uint32_t hashed_name = GenerateResourceHashedName( name );
 		const uint32_t* resource_hashed_names = binding->HashedNames();
 		for( uint32_t i = 0; i < binding->count; ++i )
 		{
@@ -334,7 +333,7 @@ namespace
 	template< RDIXResourceSlot::EType B, typename T >
 	bool _SetResource2( RDIXResourceBinding* impl, const char* name, const T* resourcePtr )
 	{
-		uint32_t index = _FindBinding( impl, name );
+		uint32_t index = _FindBinding( impl, GenerateResourceHashedName( name ) );
 		if( index == UINT32_MAX )
 		{
 			SYS_LOG_ERROR( "Resource '%s' not found in descriptor", name );
@@ -349,7 +348,7 @@ namespace
 
 bool ClearResource( RDICommandQueue * cmdq, RDIXResourceBinding* binding, const char * name )
 {
-	uint32_t index = _FindBinding( binding, name );
+	uint32_t index = _FindBinding( binding, GenerateResourceHashedName( name ) );
 	if( index == UINT32_MAX )
 	{
 		SYS_LOG_ERROR( "Resource '%s' not found in descriptor", name );
@@ -427,7 +426,11 @@ void BindResources( RDICommandQueue* cmdq, RDIXResourceBinding* rbind )
 
 uint32_t FindResource( RDIXResourceBinding* binding, const char* name )
 {
-	return _FindBinding( binding, name );
+	return _FindBinding( binding, GenerateResourceHashedName( name ) );
+}
+uint32_t FindResourceByHash( RDIXResourceBinding* binding, uint32_t hashed_name )
+{
+	return _FindBinding( binding, hashed_name );
 }
 
 void SetResourceROByIndex    ( RDIXResourceBinding* rbind, uint32_t index, const RDIResourceRO* resource )     { _SetResource1<RDIXResourceSlot::READ_ONLY>( rbind, index, resource );}
@@ -439,10 +442,6 @@ bool SetResourceRW           ( RDIXResourceBinding* rbind, const char* name, con
 bool SetConstantBuffer       ( RDIXResourceBinding* rbind, const char* name, const RDIConstantBuffer* cbuffer ){ return _SetResource2<RDIXResourceSlot::UNIFORM>( rbind, name, cbuffer );}
 bool SetSampler              ( RDIXResourceBinding* rbind, const char* name, const RDISampler* sampler )       { return _SetResource2<RDIXResourceSlot::SAMPLER>( rbind, name, sampler );}
 
-uint32_t GenerateResourceHashedName( const char * name )
-{
-	return murmur3_hash32( name, (uint32_t)strlen( name ), tag32_t( "RDES" ) );
-}
 
 
 
@@ -769,8 +768,14 @@ RDIXRenderSource* CreateRenderSourceFromShape( RDIDevice* dev, const poly_shape_
     return CreateRenderSource( dev, desc, allocator );
 }
 
-RDIXRenderSource* CreateRenderSourceFromMemory( RDIDevice* dev, const RDIXMeshFile* header, BXIAllocator* allocator )
+RDIXRenderSource* CreateRenderSourceFromMemory( RDIDevice* dev, const void* blob, uint32_t blob_size, const RDIXMeshFile* header, BXIAllocator* allocator )
 {
+    if( !ValidateMeshFile( blob, blob_size, header ) )
+    {
+        SYS_LOG_ERROR( "Invalid mesh file" );
+        return nullptr;
+    }
+
     RDIXRenderSourceDesc desc = {};
     desc.Count( header->num_vertices, header->num_indices );
 
@@ -794,6 +799,84 @@ RDIXRenderSource* CreateRenderSourceFromMemory( RDIDevice* dev, const RDIXMeshFi
     return CreateRenderSource( dev, desc, allocator );
 }
 
+blob_ref_t WriteMeshFile( blob_builder_t* b, const RDIXRenderSourceDesc& desc )
+{
+    SYS_ASSERT( desc.shared_index_buffer.id == 0 );
+    SYS_ASSERT( desc.vertex_layout.count <= RDIEVertexSlot::COUNT );
+    SYS_ASSERT( desc.num_indices == 0 || desc.index_type == RDIEType::USHORT || desc.index_type == RDIEType::UINT );
+
+    const blob_ref_t header_ref = blob_builder::allocate<RDIXMeshFile>( b );
+    {
+        RDIXMeshFile* header = blob_builder::get<RDIXMeshFile>( b, header_ref );
+        header->num_vertices = desc.num_vertices;
+        header->num_indices = desc.num_indices;
+        header->num_streams = (uint16_t)desc.vertex_layout.count;
+        header->num_draw_ranges = (uint16_t)desc.num_draw_ranges;
+        header->flag_use_16bit_indices = desc.index_type == RDIEType::USHORT;
+        for( uint32_t i = 0; i < desc.vertex_layout.count; ++i )
+            header->descs[i] = desc.vertex_layout.descs[i];
+    }
+
+    // streams are written one after another, header pointer is not valid after write
+    for( uint32_t i = 0; i < desc.vertex_layout.count; ++i )
+    {
+        const uint32_t stream_size = desc.vertex_layout.descs[i].ByteWidth() * desc.num_vertices;
+        const blob_ref_t stream_ref = blob_builder::write( b, desc.vertex_data[i], stream_size, 16 );
+        blob_builder::link( b, blob_builder::field( header_ref, offsetof( RDIXMeshFile, offset_streams ) + i * sizeof( uint32_t ) ), stream_ref );
+    }
+
+    if( desc.num_indices )
+    {
+        const uint32_t index_size = RDIEType::stride[desc.index_type] * desc.num_indices;
+        const blob_ref_t indices_ref = blob_builder::write( b, desc.index_data, index_size, 16 );
+        blob_builder::link( b, blob_builder::field( header_ref, offsetof( RDIXMeshFile, offset_indices ) ), indices_ref );
+    }
+
+    if( desc.num_draw_ranges )
+    {
+        const blob_ref_t ranges_ref = blob_builder::write_array( b, desc.draw_ranges, desc.num_draw_ranges );
+        blob_builder::link( b, blob_builder::field( header_ref, offsetof( RDIXMeshFile, offset_draw_ranges ) ), ranges_ref );
+    }
+
+    // round trip: what is written has to pass validation done at load
+    SYS_ASSERT( ValidateMeshFile( b->data, b->size, blob_builder::get<RDIXMeshFile>( b, header_ref ) ) );
+    return header_ref;
+}
+
+bool ValidateMeshFile( const void* blob, uint32_t blob_size, const RDIXMeshFile* mesh )
+{
+    const uint8_t* begin = (const uint8_t*)blob;
+    if( (const uint8_t*)mesh < begin || (const uint8_t*)(mesh + 1) > begin + blob_size )
+        return false;
+
+    if( mesh->num_streams > RDIEVertexSlot::COUNT )
+        return false;
+
+    for( uint32_t i = 0; i < mesh->num_streams; ++i )
+    {
+        const RDIVertexBufferDesc desc = mesh->descs[i];
+        if( desc.dataType >= RDIEType::COUNT )
+            return false;
+
+        const uint64_t stream_size = (uint64_t)desc.ByteWidth() * mesh->num_vertices;
+        if( stream_size > blob_size )
+            return false;
+
+        if( !blob_validate::offset( blob, blob_size, mesh->offset_streams[i], (uint32_t)stream_size, 4 ) )
+            return false;
+    }
+
+    const uint32_t index_stride = (mesh->flag_use_16bit_indices) ? sizeof( uint16_t ) : sizeof( uint32_t );
+    const uint64_t index_size = (uint64_t)index_stride * mesh->num_indices;
+    if( index_size > blob_size || !blob_validate::offset( blob, blob_size, mesh->offset_indices, (uint32_t)index_size, index_stride ) )
+        return false;
+
+    if( !blob_validate::array<RDIXRenderSourceRange>( blob, blob_size, mesh->offset_draw_ranges, mesh->num_draw_ranges ) )
+        return false;
+
+    return true;
+}
+
 void DestroyRenderSource( RDIXRenderSource** rsource )
 {
 	if( !rsource[0] )
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <foundation/type.h>
+#include <foundation/hash.h>
+#include <foundation/tag.h>
 //#include <initializer_list>
 
 #include "rdix_type.h"
+#include <foundation/blob_builder.h>
 #include <util/par_shapes/par_shapes.h>
 #include <util/poly_shape/poly_shape.h>
 
@@ -62,6 +65,7 @@ RDIXResourceBinding* CloneResourceBinding( const RDIXResourceBinding* binding, B
 bool				 ClearResource( RDICommandQueue* cmdq, RDIXResourceBinding* binding, const char* name );
 void				 BindResources( RDICommandQueue* cmdq, RDIXResourceBinding* binding );
 uint32_t			 FindResource( RDIXResourceBinding* binding, const char* name );
+uint32_t			 FindResourceByHash( RDIXResourceBinding* binding, uint32_t hashed_name ); // hashed_name from GenerateResourceHashedName
 void				 SetResourceROByIndex( RDIXResourceBinding* binding, uint32_t index, const RDIResourceRO* resource );
 void				 SetResourceRWByIndex( RDIXResourceBinding* binding, uint32_t index, const RDIResourceRW* resource );
 void				 SetConstantBufferByIndex( RDIXResourceBinding* binding, uint32_t index, const RDIConstantBuffer* cbuffer );
@@ -71,7 +75,8 @@ bool				 SetResourceRW( RDIXResourceBinding* binding, const char* name, const RD
 bool				 SetConstantBuffer( RDIXResourceBinding* binding, const char* name, const RDIConstantBuffer* cbuffer );
 bool				 SetSampler( RDIXResourceBinding* binding, const char* name, const RDISampler* sampler );
 
-uint32_t			 GenerateResourceHashedName( const char* name );
+// constexpr, so hash of literal name can be computed once: static constexpr uint32_t h = GenerateResourceHashedName( "..." );
+constexpr uint32_t	 GenerateResourceHashedName( const char* name ) { return constexpr_hash::murmur3_hash32( name, constexpr_hash::length( name ), tag32_t( "RDES" ) ); }
 RDIXResourceBindingMemoryRequirments CalculateResourceBindingMemoryRequirments( const RDIXResourceLayout& layout );
 
 
@@ -95,8 +100,15 @@ RDIXRenderSource* CloneForCPUSkinning( RDIDevice* dev, const RDIXRenderSource* b
 RDIXRenderSource* CloneForGPUSkinning( RDIDevice* dev, const RDIXRenderSource* base, uint32_t skinned_slot_mask = RDIEVertexSlot::SkinningMaskPosNrm() );
 RDIXRenderSource* CreateRenderSourceFromShape( RDIDevice* dev, const par_shapes_mesh* shape, BXIAllocator* allocator );
 RDIXRenderSource* CreateRenderSourceFromShape( RDIDevice* dev, const poly_shape_t* shape, BXIAllocator* allocator );
-RDIXRenderSource* CreateRenderSourceFromMemory( RDIDevice* dev, const RDIXMeshFile* header, BXIAllocator* allocator );
+// mesh is validated against blob it lives in. Returns nullptr when it's invalid
+RDIXRenderSource* CreateRenderSourceFromMemory( RDIDevice* dev, const void* blob, uint32_t blob_size, const RDIXMeshFile* header, BXIAllocator* allocator );
 void			  DestroyRenderSource( RDIXRenderSource** rsource );
+
+// --- MeshFile
+// writes RDIXMeshFile with all its streams. Returns reference to mesh header
+blob_ref_t        WriteMeshFile   ( blob_builder_t* b, const RDIXRenderSourceDesc& desc );
+// bounds-checks every offset once, so mesh can be used without further checks
+bool              ValidateMeshFile( const void* blob, uint32_t blob_size, const RDIXMeshFile* mesh );
 void			  BindRenderSource( RDICommandQueue* cmdq, RDIXRenderSource* renderSource );
 void			  SubmitRenderSource( RDICommandQueue* cmdq, RDIXRenderSource* renderSource, uint32_t rangeIndex = 0 );
 void			  SubmitRenderSource( RDICommandQueue* cmdq, RDIXRenderSource* renderSource, const RDIXRenderSourceRange& range );
@@ -12,6 +12,42 @@ struct RSMResourceData
     BXIAllocator* allocator = nullptr;
 };
 
+// Filled by RSMLoader::Dependencies. Paths are copied out before Dependencies returns,
+// so they can point directly into file data.
+struct RSMDependencyList
+{
+    static constexpr uint32_t MAX_DEPENDENCIES = 32;
+
+    struct Entry
+    {
+        const char* path;
+        uint64_t hash;
+        void* system; // nullptr means the same system as dependant resource
+    };
+
+    Entry entry[MAX_DEPENDENCIES];
+    uint32_t count = 0;
+
+    bool Add( const char* relative_path, void* system = nullptr )
+    {
+        if( count == MAX_DEPENDENCIES )
+            return false;
+
+        entry[count++] = { relative_path, 0, system };
+        return true;
+    }
+    // resource has to be already known to resource manager, otherwise dependency fails
+    bool Add( uint64_t resource_hash )
+    {
+        if( count == MAX_DEPENDENCIES )
+            return false;
+
+        entry[count++] = { nullptr, resource_hash, nullptr };
+        return true;
+    }
+};
+
+struct RSMStreamingLoader;
 struct RSMLoader
 {
     virtual ~RSMLoader() {}
@@ -20,6 +56,39 @@ struct RSMLoader
     virtual bool IsBinary() const = 0;
     virtual bool Load( RSMResourceData* out, const void* data, uint32_t size, BXIAllocator* allocator, void* system );
     virtual void Unload( RSMResourceData* in_out );
+
+    // Called with file data before Load. Resource manager loads all listed resources (their dependencies too)
+    // and calls Load when every one of them is READY. When any of them fails, resource fails too.
+    // Dependencies are released when resource is unloaded. Dependency closing a cycle fails the resource.
+    virtual void Dependencies( RSMDependencyList* deps, const void* data, uint32_t size, void* system ) {}
+
+    // loaders which consume file in chunks derive from RSMStreamingLoader
+    virtual RSMStreamingLoader* Streaming() { return nullptr; }
+
+    // Load and Unload are called from job worker threads, possibly for many resources at once.
+    // 0 means no limit on loads running at the same time
+    virtual uint32_t MaxConcurrentLoads() const { return 0; }
+    // Load and Unload are called from RSM::Update (e.g. when loader touches graphics context)
+    virtual bool MainThreadOnly() const { return false; }
+};
+
+// Receives file in chunks as they are read, so whole file never has to be resident in memory.
+// Begin and Chunk are called from filesystem thread, End is called from the same thread as Load
+// and is always called, even when file can not be read.
+// Contract:
+//  - StreamBegin is called once before first StreamChunk. Empty file gets StreamBegin( total_size = 0 )
+//    followed by one StreamChunk( nullptr, 0, 0 )
+//  - when file can not be opened, StreamEnd( stream_ok = false ) is called without StreamBegin. 'out' is zeroed then
+//  - when Begin or Chunk returns false, streaming stops and StreamEnd is called with stream_ok = false
+struct RSMStreamingLoader : RSMLoader
+{
+    bool IsBinary() const override { return true; }
+    RSMStreamingLoader* Streaming() override final { return this; }
+
+    virtual uint32_t ChunkSize() const { return BIT_MEGA_BYTE( 1 ); }
+    virtual bool StreamBegin( RSMResourceData* out, uint32_t total_size, BXIAllocator* allocator, void* system ) = 0;
+    virtual bool StreamChunk( RSMResourceData* out, const void* chunk, uint32_t chunk_size, uint32_t offset, void* system ) = 0;
+    virtual bool StreamEnd( RSMResourceData* out, bool stream_ok, void* system ) = 0;
 };
 
 using RSMLoaderCreator = RSMLoader*(BXIAllocator* allocator);
@@ -8,14 +8,24 @@
 #include <foundation/debug.h>
 #include <foundation/hash.h>
 #include <foundation/string_util.h>
+#include <foundation/string_interner.h>
+#include <foundation/array.h>
+#include <foundation/small_array.h>
+#include <foundation/time.h>
 
 #include <foundation/thread/mutex.h>
 #include <foundation/thread/semaphore.h>
+#include <foundation/thread/lockfree_queue.h>
 
 #include <filesystem/filesystem.h>
+#include <job/job.h>
 
 #include <atomic>
 #include <thread>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 #define RSM_LOG_STATUS 1
 
@@ -34,6 +44,33 @@ struct RSMPendingResource
     id_t id;
     BXFileHandle hfile;
     void* user_system;
+    uint8_t streamed;
+    uint8_t stream_ok;
+    uint8_t dependencies_ready;
+    uint8_t dependencies_ok;
+    uint8_t reload;
+};
+
+struct RSMReloadedResource
+{
+    id_t id;
+    uint8_t ok;
+    uint8_t loader_index; // valid when ok. Resource can be gone when data arrives, so loader is stored here
+    RSMResourceData data;
+};
+
+struct RSMRetiredResource
+{
+    RSMResourceData data;
+    uint64_t unload_frame;
+    uint8_t loader_index;
+};
+
+struct RSMWaitingResource
+{
+    RSMPendingResource pending;
+    uint32_t nb_pending_dependencies;
+    uint32_t failed;
 };
 
 template< typename T, typename Tlock >
@@ -56,35 +93,331 @@ namespace RSMEInternalState
     enum Enum : uint8_t
     {
         MANAGED = BIT_OFFSET(0),
+        RELOADING = BIT_OFFSET(1),
     };
 }
 
+static constexpr uint32_t RSM_MAX_RESOURCES = 1 << 16;
+static constexpr uint32_t RSM_BATCH_INLINE = 32; // typical batches fit on stack, bigger ones spill to pending_resources_allocator
+static constexpr uint32_t RSM_PAGE_SHIFT = 10;
+static constexpr uint32_t RSM_PAGE_SIZE = 1 << RSM_PAGE_SHIFT;
+static constexpr uint32_t RSM_PAGE_MASK = RSM_PAGE_SIZE - 1;
+static constexpr uint32_t RSM_MAX_PAGES = RSM_MAX_RESOURCES / RSM_PAGE_SIZE;
+
+// data replaced by hot reload is unloaded after this number of frames, when no frame in flight can reference it
+static constexpr uint64_t RSM_RETIRE_FRAMES = 3;
+
+// prefetch never has more loads in flight than this, so it doesn't delay loads requested by game
+static constexpr uint32_t RSM_PREFETCH_MAX_IN_FLIGHT = 8;
+
+static constexpr uint32_t RSM_LRU_NULL = UINT32_MAX;
+static constexpr uint64_t RSM_DEFAULT_CACHE_BUDGET = BIT_MEGA_BYTE( 64 );
+// cached resources keep their ids, so many small resources could use up all ids while fitting in byte budget
+static constexpr uint32_t RSM_MAX_CACHED = RSM_MAX_RESOURCES / 4;
+
+// Elements are allocated in pages of RSM_PAGE_SIZE. Pages are never moved nor freed until shutdown,
+// so references to existing elements stay valid when array grows.
+template< typename T >
+struct RSMPagedArray
+{
+    T* page[RSM_MAX_PAGES] = {};
+
+          T& operator[]( uint32_t i )       { return page[i >> RSM_PAGE_SHIFT][i & RSM_PAGE_MASK]; }
+    const T& operator[]( uint32_t i ) const { return page[i >> RSM_PAGE_SHIFT][i & RSM_PAGE_MASK]; }
+
+    static constexpr uint32_t PageMemorySize() { return sizeof( T ) * RSM_PAGE_SIZE + ALIGNOF( T ); }
+
+    uint8_t* ConstructPage( uint32_t page_index, uint8_t* memory )
+    {
+        T* elements = (T*)TYPE_ALIGN( memory, ALIGNOF( T ) );
+        for( uint32_t i = 0; i < RSM_PAGE_SIZE; ++i )
+            new( &elements[i] ) T();
+
+        page[page_index] = elements;
+        return (uint8_t*)(elements + RSM_PAGE_SIZE);
+    }
+    void DestroyPage( uint32_t page_index )
+    {
+        T* elements = page[page_index];
+        for( uint32_t i = 0; i < RSM_PAGE_SIZE; ++i )
+            elements[i].~T();
+
+        page[page_index] = nullptr;
+    }
+};
+
+// Open addressing hash table with lock free reads. Writers are serialized by lookup_lock.
+// Removed key just gets null value, so probe sequences are never broken and readers don't need tombstones.
+// When keys (live and removed) reach half of capacity, live ones are rehashed to new table, which is published
+// with atomic swap. Old table can still be read by other threads, so it's returned to caller to be freed later.
+// Readers are not tied to frames (jobs, tool threads), so old table is freed only when no Find is in progress.
+struct RSMLookupTable
+{
+    // matches first page of resources. Table grows with number of live keys, which can't exceed paged capacity
+    static constexpr uint32_t MIN_CAPACITY = RSM_PAGE_SIZE * 2;
+
+    struct Slot
+    {
+        std::atomic_uint64_t key;
+        std::atomic_uint32_t value;
+    };
+    struct Table
+    {
+        Slot* slots;
+        uint32_t capacity;
+        uint32_t mask;
+    };
+    std::atomic<Table*> table = { nullptr };
+    mutable std::atomic_uint32_t nb_readers = { 0 }; // Find calls in progress
+    uint32_t nb_keys = 0; // including removed ones
+    uint32_t nb_live = 0;
+    BXIAllocator* allocator = nullptr;
+
+    static inline uint32_t Home( uint64_t key, uint32_t mask ) { return (uint32_t)(key ^ (key >> 32)) & mask; }
+
+    static Table* CreateTable( BXIAllocator* allocator, uint32_t capacity )
+    {
+        SYS_ASSERT( is_pow2( capacity ) );
+        const size_t header_size = TYPE_ALIGN( sizeof( Table ), ALIGNOF( Slot ) );
+        const size_t mem_size = header_size + capacity * sizeof( Slot );
+        uint8_t* mem = (uint8_t*)BX_MALLOC( allocator, mem_size, ALIGNOF( Slot ) );
+        memset( mem, 0x00, mem_size );
+
+        Table* t = (Table*)mem;
+        t->slots = (Slot*)(mem + header_size);
+        t->capacity = capacity;
+        t->mask = capacity - 1;
+        return t;
+    }
+
+    void StartUp( BXIAllocator* a )
+    {
+        allocator = a;
+        table.store( CreateTable( allocator, MIN_CAPACITY ), std::memory_order_release );
+    }
+    void ShutDown()
+    {
+        Table* t = table.exchange( nullptr );
+        BX_FREE( allocator, t );
+    }
+
+    // reader is counted before it loads table pointer. When count is zero after swap, nobody can hold old table
+    id_t Find( uint64_t key ) const
+    {
+        nb_readers.fetch_add( 1, std::memory_order_seq_cst );
+        const Table* t = table.load( std::memory_order_seq_cst );
+
+        id_t result = { 0 };
+        for( uint32_t i = Home( key, t->mask ), n = 0; n < t->capacity; i = (i + 1) & t->mask, ++n )
+        {
+            const uint64_t slot_key = t->slots[i].key.load( std::memory_order_acquire );
+            if( slot_key == key )
+            {
+                result.hash = t->slots[i].value.load( std::memory_order_acquire );
+                break;
+            }
+            if( slot_key == 0 )
+                break;
+        }
+
+        nb_readers.fetch_sub( 1, std::memory_order_release );
+        return result;
+    }
+
+    // retired tables can be freed only when this returns true
+    bool NoReaders() const { return nb_readers.load( std::memory_order_seq_cst ) == 0; }
+
+    // returns table replaced by rebuild or nullptr. Has to be freed when no reader can use it anymore
+    Table* Set( uint64_t key, id_t value )
+    {
+        SYS_ASSERT( key != 0 );
+        Table* t = table.load( std::memory_order_relaxed );
+        uint32_t i = Home( key, t->mask );
+        for( ;; i = (i + 1) & t->mask )
+        {
+            const uint64_t slot_key = t->slots[i].key.load( std::memory_order_relaxed );
+            if( slot_key == key )
+            {
+                const uint32_t old_value = t->slots[i].value.load( std::memory_order_relaxed );
+                nb_live += (value.hash != 0) - (old_value != 0);
+                t->slots[i].value.store( value.hash, std::memory_order_release );
+                return nullptr;
+            }
+            if( slot_key == 0 )
+                break;
+        }
+
+        // removing key which is not in table
+        if( value.hash == 0 )
+            return nullptr;
+
+        Table* retired = nullptr;
+        if( (nb_keys + 1) > t->capacity / 2 )
+        {
+            retired = t;
+            t = Rebuild( t );
+            i = Home( key, t->mask );
+            while( t->slots[i].key.load( std::memory_order_relaxed ) != 0 )
+                i = (i + 1) & t->mask;
+        }
+
+        ++nb_keys;
+        ++nb_live;
+        // value has to be visible before key is published
+        t->slots[i].value.store( value.hash, std::memory_order_relaxed );
+        t->slots[i].key.store( key, std::memory_order_release );
+        return retired;
+    }
+
+    // never rebuilds table
+    void Remove( uint64_t key ) { Set( key, { 0 } ); }
+
+private:
+    // copies live keys to new table with room for twice as many and publishes it
+    Table* Rebuild( const Table* old )
+    {
+        uint32_t capacity = MIN_CAPACITY;
+        while( capacity < (nb_live + 1) * 4 )
+            capacity *= 2;
+
+        Table* t = CreateTable( allocator, capacity );
+        uint32_t count = 0;
+        for( uint32_t j = 0; j < old->capacity; ++j )
+        {
+            const uint64_t key = old->slots[j].key.load( std::memory_order_relaxed );
+            const uint32_t value = old->slots[j].value.load( std::memory_order_relaxed );
+            if( key == 0 || value == 0 )
+                continue;
+
+            uint32_t i = Home( key, t->mask );
+            while( t->slots[i].key.load( std::memory_order_relaxed ) != 0 )
+                i = (i + 1) & t->mask;
+
+            t->slots[i].key.store( key, std::memory_order_relaxed );
+            t->slots[i].value.store( value, std::memory_order_relaxed );
+            ++count;
+        }
+        SYS_ASSERT( count == nb_live );
+        nb_keys = count;
+
+        // makes whole content of table visible to readers and is ordered with their reader count (see Find)
+        table.store( t, std::memory_order_seq_cst );
+        return t;
+    }
+};
+
+// timestamps of load stages in microseconds. Each one is written by a single stage of the pipeline
+struct RSMLoadTiming
+{
+    uint64_t request = 0;
+    uint64_t io_done = 0;
+    uint64_t load_begin = 0;
+};
+
+struct RSMTypeCounters
+{
+    std::atomic_uint64_t nb_loads;
+    std::atomic_uint64_t nb_failed;
+    std::atomic_uint64_t queue_us;
+    std::atomic_uint64_t io_us;
+    std::atomic_uint64_t cpu_us;
+    std::atomic_uint64_t bytes_read;
+    std::atomic_uint64_t bytes_resident;
+    std::atomic_uint64_t histogram[RSMLoadStats::HISTOGRAM_SIZE];
+};
+
 struct RSMImpl
 {
-    static constexpr uint32_t MAX_RESOURCES = 1 << 16;
+    static constexpr uint32_t MAX_RESOURCES = RSM_MAX_RESOURCES;
     static constexpr uint32_t MAX_TYPES = 0x40;
     static constexpr uint8_t INVALID_LOADER_INDEX = 0xFF;
     
     mutex_t id_lock;
     id_table_t<MAX_RESOURCES> id_alloc;
 
-    string_t        rname        [MAX_RESOURCES] = {};
-    RSMResourceHash rhash        [MAX_RESOURCES] = {};
-    id_t            rid          [MAX_RESOURCES] = {};
-    RSMEState::E    rstate       [MAX_RESOURCES] = {};
-    RSMResourceData rdata        [MAX_RESOURCES] = {};
-    uint8_t         rloader_index[MAX_RESOURCES] = {};
-    uint16_t        rrefcount    [MAX_RESOURCES] = {};
-    uint8_t         rflags       [MAX_RESOURCES] = {};
+    RSMPagedArray<interned_string_t> rname;
+    RSMPagedArray<RSMResourceHash> rhash;
+    RSMPagedArray<id_t>            rid;
+    RSMPagedArray<std::atomic<RSMEState::E>> rstate;
+    RSMPagedArray<RSMResourceData> rdata;
+    RSMPagedArray<uint8_t>         rloader_index;
+    RSMPagedArray<std::atomic_uint32_t> rrefcount; // generation << 16 | count
+    RSMPagedArray<std::atomic_uint32_t> rbusy;     // number of load stages (load job, stream chunk) using rdata right now
+    RSMPagedArray<uint8_t>         rflags;
+    RSMPagedArray<void*>           rsystem;
+    RSMPagedArray<uint32_t>        rversion;
+    RSMPagedArray<uint32_t>        rlru_prev;
+    RSMPagedArray<uint32_t>        rlru_next;
+    RSMPagedArray<RSMLoadTiming>   rtiming;
+
+    // one allocation holds page of every array
+    void*    page_memory[RSM_MAX_PAGES] = {};
+    uint32_t nb_pages = 0;
 
     mutex_t lookup_lock;
-    hash_t<id_t> lookup;
-
-    mutex_t to_load_lock;
-    mutex_t to_unload_lock;
-
-    queue_t<RSMPendingResource> to_load;
-    queue_t<RSMPendingResource> to_unload;
+    RSMLookupTable lookup;
+
+    // Released managed resources stay loaded (and in lookup) until cache exceeds budget.
+    // Most recently released resource is at head. Guarded by lookup_lock
+    uint32_t lru_head = RSM_LRU_NULL;
+    uint32_t lru_tail = RSM_LRU_NULL;
+    uint64_t lru_bytes = 0;
+    uint32_t lru_count = 0;
+    uint64_t lru_budget = RSM_DEFAULT_CACHE_BUDGET;
+
+    // Filled from io callbacks, jobs and main thread. Drained by background thread (to_load) and main thread (to_unload).
+    // Resource has at most one entry in each, so rings are created big enough to never fill up.
+    // If push fails anyway, entry goes to locked queue drained by main thread instead of being dropped
+    mpmc_queue_t<RSMPendingResource> to_load;
+    mpmc_queue_t<RSMPendingResource> to_unload;
+    mutex_t unload_overflow_lock;
+    queue_t<RSMPendingResource> unload_overflow;
+
+    // dependency graph
+    mutex_t deps_lock;
+    hash_t<RSMWaitingResource> deps_waiting;  // key: id of resource which waits for dependencies
+    hash_t<id_t> deps_dependants;             // multi hash. key: id of dependency, value: id of waiting resource
+    hash_t<RSMResourceID> deps_dependencies;  // multi hash. key: id of resource, value: dependency held by resource
+
+    // hot reload
+    mutex_t reloaded_lock;
+    queue_t<RSMReloadedResource> reloaded;
+    array_t<RSMRetiredResource> retired; // touched only by main thread
+    array_t<RSMLookupTable::Table*> retired_lookup; // guarded by lookup_lock. Moved to 'retired' on main thread
+    uint64_t frame = 0;
+    bool hot_reload = false;
+
+    // prefetch manifest recording
+    mutex_t record_lock;
+    string_buffer_t record;
+    hash_t<uint8_t> record_seen;
+    string_t record_path;
+    uint64_t record_start_ms = 0;
+    std::atomic_bool is_recording = false;
+
+    // prefetch manifest replay. Touched only by main thread
+    string_buffer_t prefetch;
+    string_buffer_it prefetch_it;
+    array_t<RSMResourceID> prefetch_in_flight;
+    void* prefetch_system = nullptr;
+
+    // telemetry
+    RSMTypeCounters type_counters[MAX_TYPES] = {};
+    mutex_t slowest_lock;
+    RSMSlowLoad slowest[RSMSlowLoad::MAX_COUNT] = {};
+    uint32_t nb_slowest = 0;
+    std::atomic_uint64_t slowest_threshold_us = 0; // loads faster than this don't have to take slowest_lock
+
+    mutex_t main_thread_load_lock;
+    queue_t<RSMPendingResource> main_thread_load;
+
+    // touched only by background thread. Loads which hit concurrency limit of their loader, one queue per loader
+    queue_t<RSMPendingResource> deferred_load[MAX_TYPES];
+    
+    std::atomic_uint32_t loader_in_flight[MAX_TYPES] = {};
+    std::atomic_uint32_t nb_jobs_in_flight = 0;
+    std::mutex jobs_lock;
+    std::condition_variable jobs_done_cv; // signaled when nb_jobs_in_flight drops to zero
 
     RSMLoader* loader[MAX_TYPES] = {};
     uint32_t loader_supported_type[MAX_TYPES] = {};
@@ -101,248 +434,1266 @@ struct RSMImpl
     semaphore_t sema;
     std::atomic_uint32_t is_running = 0;
 
+    // signaled every time resource reaches READY or FAIL
+    std::mutex wait_lock;
+    std::condition_variable wait_cv;
+
     bool IsAlive( id_t id ) const { return id_table::has( id_alloc, id ); }
+    uint32_t Capacity() const { return nb_pages * RSM_PAGE_SIZE; }
 };
 
-static RSMImpl* _rsm = nullptr;
+static void AllocatePage( RSMImpl* rsm )
+{
+    SYS_ASSERT( rsm->nb_pages < RSM_MAX_PAGES );
+    const uint32_t page_index = rsm->nb_pages;
 
-static void RemoveResourceEntry( RSMImpl* rsm, id_t id )
+    uint32_t mem_size = 0;
+    mem_size += rsm->rname        .PageMemorySize();
+    mem_size += rsm->rhash        .PageMemorySize();
+    mem_size += rsm->rid          .PageMemorySize();
+    mem_size += rsm->rstate       .PageMemorySize();
+    mem_size += rsm->rdata        .PageMemorySize();
+    mem_size += rsm->rloader_index.PageMemorySize();
+    mem_size += rsm->rrefcount    .PageMemorySize();
+    mem_size += rsm->rbusy        .PageMemorySize();
+    mem_size += rsm->rflags       .PageMemorySize();
+    mem_size += rsm->rsystem      .PageMemorySize();
+    mem_size += rsm->rversion     .PageMemorySize();
+    mem_size += rsm->rlru_prev    .PageMemorySize();
+    mem_size += rsm->rlru_next    .PageMemorySize();
+    mem_size += rsm->rtiming      .PageMemorySize();
+
+    uint8_t* memory = (uint8_t*)BX_MALLOC( rsm->main_allocator, mem_size, 16 );
+    uint8_t* current = memory;
+    current = rsm->rname        .ConstructPage( page_index, current );
+    current = rsm->rhash        .ConstructPage( page_index, current );
+    current = rsm->rid          .ConstructPage( page_index, current );
+    current = rsm->rstate       .ConstructPage( page_index, current );
+    current = rsm->rdata        .ConstructPage( page_index, current );
+    current = rsm->rloader_index.ConstructPage( page_index, current );
+    current = rsm->rrefcount    .ConstructPage( page_index, current );
+    current = rsm->rbusy        .ConstructPage( page_index, current );
+    current = rsm->rflags       .ConstructPage( page_index, current );
+    current = rsm->rsystem      .ConstructPage( page_index, current );
+    current = rsm->rversion     .ConstructPage( page_index, current );
+    current = rsm->rlru_prev    .ConstructPage( page_index, current );
+    current = rsm->rlru_next    .ConstructPage( page_index, current );
+    current = rsm->rtiming      .ConstructPage( page_index, current );
+    SYS_ASSERT( current <= memory + mem_size );
+
+    rsm->page_memory[page_index] = memory;
+    rsm->nb_pages += 1;
+}
+
+static void FreePages( RSMImpl* rsm )
 {
-    string::free( &rsm->rname[id.index] );
-    rsm->rhash        [id.index] = { 0 };
-    rsm->rid          [id.index] = { 0 };
-    rsm->rstate       [id.index] = RSMEState::UNLOADED;
-    rsm->rdata        [id.index] = {};
-    rsm->rloader_index[id.index] = RSMImpl::INVALID_LOADER_INDEX;
+    for( uint32_t page_index = 0; page_index < rsm->nb_pages; ++page_index )
     {
-        scope_mutex_t guard( rsm->id_lock );
-        id_table::destroy( rsm->id_alloc, id );
+        rsm->rname        .DestroyPage( page_index );
+        rsm->rhash        .DestroyPage( page_index );
+        rsm->rid          .DestroyPage( page_index );
+        rsm->rstate       .DestroyPage( page_index );
+        rsm->rdata        .DestroyPage( page_index );
+        rsm->rloader_index.DestroyPage( page_index );
+        rsm->rrefcount    .DestroyPage( page_index );
+        rsm->rbusy        .DestroyPage( page_index );
+        rsm->rflags       .DestroyPage( page_index );
+        rsm->rsystem      .DestroyPage( page_index );
+        rsm->rversion     .DestroyPage( page_index );
+        rsm->rlru_prev    .DestroyPage( page_index );
+        rsm->rlru_next    .DestroyPage( page_index );
+        rsm->rtiming      .DestroyPage( page_index );
+
+        BX_FREE0( rsm->main_allocator, rsm->page_memory[page_index] );
     }
+    rsm->nb_pages = 0;
 }
 
-static void BackgroundThread( RSMImpl* rsm )
+static void CreateResourceEntries( RSMImpl* rsm, id_t* ids, uint32_t count )
 {
-    while( rsm->is_running )
+    scope_mutex_t guard( rsm->id_lock );
+    for( uint32_t i = 0; i < count; ++i )
     {
-        rsm->sema.wait();
-
-        RSMPendingResource pending = {};
-        while( PopFrontQueue( &pending, rsm->to_load, rsm->to_load_lock ) )
+        ids[i] = id_table::create( rsm->id_alloc );
+        while( ids[i].index >= rsm->Capacity() )
         {
-            bool should_delete_file_data = false;
-            if( rsm->IsAlive( pending.id ) )
-            {
-                BXFile file = {};
-                BXEFileStatus::E status = rsm->filesystem->File( &file, pending.hfile );
-                SYS_ASSERT( status == BXEFileStatus::READY );
-
-                RSMResourceData* data = &rsm->rdata[pending.id.index];
-
-                const uint32_t loader_index = rsm->rloader_index[pending.id.index];
-                RSMLoader* loader = rsm->loader[loader_index];
-                const bool load_ok = loader->Load( data, file.pointer, file.size, file.allocator, pending.user_system );
-                if( load_ok )
-                {
-                    rsm->rstate[pending.id.index] = RSMEState::READY;
-                }
-                else
-                {
-                    SYS_LOG_ERROR( "Resource failed to load (%s)", rsm->rname[pending.id.index].c_str() );
-                    rsm->rstate[pending.id.index] = RSMEState::FAIL;
-                }
-
-                should_delete_file_data = !load_ok || (data->pointer != file.pointer);
-            }
-            rsm->filesystem->CloseFile( &pending.hfile, should_delete_file_data );
+            AllocatePage( rsm );
         }
+    }
+}
+static id_t CreateResourceEntry( RSMImpl* rsm )
+{
+    id_t id;
+    CreateResourceEntries( rsm, &id, 1 );
+    return id;
+}
 
-        while( PopFrontQueue( &pending, rsm->to_unload, rsm->to_unload_lock ) )
-        {
-            if( rsm->IsAlive( pending.id ) )
-            {
-                SYS_ASSERT( rsm->rrefcount[pending.id.index] == 0 );
-
-                const uint32_t loader_index = rsm->rloader_index[pending.id.index];
-                RSMLoader* loader = rsm->loader[loader_index];
-                
-                RSMResourceData* data = &rsm->rdata[pending.id.index];                
-                loader->Unload( data );
-                if( data->allocator )
-                {
-                    BX_FREE( data->allocator, (void*)data->pointer );
-                }
+static RSMImpl* _rsm = nullptr;
 
-                RemoveResourceEntry( rsm, pending.id );
-            }
-        }
+// Reference count is packed with generation of id, so compare-exchange fails when slot has been reused in the meantime
+static inline uint32_t RefPack( id_t id, uint32_t count ) { return ((uint32_t)id.id << 16) | count; }
+static inline uint32_t RefCount( const RSMImpl* rsm, uint32_t index ) { return rsm->rrefcount[index].load( std::memory_order_acquire ) & 0xFFFF; }
+
+// lock free. Fails when resource is not referenced (it's cached or being released) or id is stale
+static bool TryAddRef( RSMImpl* rsm, id_t id )
+{
+    std::atomic_uint32_t& ref = rsm->rrefcount[id.index];
+    uint32_t current = ref.load( std::memory_order_acquire );
+    for( ;; )
+    {
+        if( (current >> 16) != id.id || (current & 0xFFFF) == 0 )
+            return false;
+        
+        SYS_ASSERT( (current & 0xFFFF) != 0xFFFF );
+        if( ref.compare_exchange_weak( current, current + 1, std::memory_order_acq_rel ) )
+            return true;
     }
 }
 
-static inline uint32_t ResourceTypeHash( const char* type )
+static void RemoveResourceEntries( RSMImpl* rsm, const id_t* ids, uint32_t count )
 {
-    const uint32_t seed = tag32_t( "RSMR" );
-    return murmur3_hash32( type, (uint32_t)strlen( type ), seed );
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        const id_t id = ids[i];
+        rsm->rname        [id.index] = {};
+        rsm->rhash        [id.index] = { 0 };
+        rsm->rid          [id.index] = { 0 };
+        rsm->rstate       [id.index] = RSMEState::UNLOADED;
+        rsm->rdata        [id.index] = {};
+        rsm->rloader_index[id.index] = RSMImpl::INVALID_LOADER_INDEX;
+        rsm->rsystem      [id.index] = nullptr;
+    }
+    
+    scope_mutex_t guard( rsm->id_lock );
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        id_table::destroy( rsm->id_alloc, ids[i] );
+    }
 }
-RSMResourceHash RSM::CreateHash( const char* relative_path )
+static void RemoveResourceEntry( RSMImpl* rsm, id_t id )
 {
-    const size_t NAME_SIZE = 256;
-    const size_t TYPE_SIZE = 32;
-    char name[NAME_SIZE];
-    char type[TYPE_SIZE];
-    memset( name, 0, sizeof( name ) );
-    memset( type, 0, sizeof( type ) );
-
-    char* str = (char*)relative_path;
+    RemoveResourceEntries( rsm, &id, 1 );
+}
 
-    str = string::token( str, name, NAME_SIZE - 1, "." );
-    if( str )
+static void NotifyWaiters( RSMImpl* rsm )
+{
+    // empty critical section makes sure waiter is either before predicate check or already sleeping
     {
-        string::token( str, type, TYPE_SIZE - 1, " .\n" );
+        std::lock_guard<std::mutex> guard( rsm->wait_lock );
     }
+    rsm->wait_cv.notify_all();
+}
 
-    const uint32_t name_len = string::length( name );
-    
-    RSMResourceHashDecoder hash_decoder;
-    hash_decoder.type = ResourceTypeHash( type );
+// rings are drained by background and main thread, which push too, so waiting for free slot could deadlock
+static void PushToLoadRing( RSMImpl* rsm, const RSMPendingResource& pending )
+{
+    if( rsm->to_load.push( pending ) )
+        return;
 
-    const uint32_t crc = crc32n( (uint8_t*)name, name_len, hash_decoder.type );
-    hash_decoder.name = murmur3_hash32( name, name_len, hash_decoder.type + name_len ) ^ crc;
-    
-    return { hash_decoder.hash };
+    SYS_LOG_WARNING( "Load queue is full. Resource is loaded on main thread" );
+    scope_mutex_t guard( rsm->main_thread_load_lock );
+    queue::push_back( rsm->main_thread_load, pending );
 }
+static void PushToUnloadRing( RSMImpl* rsm, const RSMPendingResource& pending )
+{
+    if( rsm->to_unload.push( pending ) )
+        return;
 
-static uint8_t FindLoader( RSMImpl* impl, RSMResourceHash rhash )
+    SYS_LOG_WARNING( "Unload queue is full" );
+    scope_mutex_t guard( rsm->unload_overflow_lock );
+    queue::push_back( rsm->unload_overflow, pending );
+}
+
+static void PushLoad( RSMImpl* rsm, const RSMPendingResource& pending )
 {
-    const RSMResourceHashDecoder rhash_decoded = { rhash.h };
+    PushToLoadRing( rsm, pending );
+    rsm->sema.signal();
+}
 
-    for( uint32_t i = 0; i < impl->nb_loaders; ++i )
+static void ResolveDependants( RSMImpl* rsm, id_t id, RSMEState::E state )
+{
+    scope_mutex_t guard( rsm->deps_lock );
+
+    auto* e = multi_hash::find_first( rsm->deps_dependants, (uint64_t)id.hash );
+    if( !e )
+        return;
+
+    for( ; e; e = multi_hash::find_next( rsm->deps_dependants, e ) )
     {
-        if( rhash_decoded.type == impl->loader_supported_type[i] )
+        const uint64_t key = e->value.hash;
+        RSMWaitingResource waiting = hash::get( rsm->deps_waiting, key, RSMWaitingResource{} );
+        SYS_ASSERT( waiting.nb_pending_dependencies > 0 );
+
+        waiting.failed |= (state != RSMEState::READY) ? 1 : 0;
+        if( --waiting.nb_pending_dependencies == 0 )
         {
-            return uint8_t( i );
+            hash::remove( rsm->deps_waiting, key );
+            waiting.pending.dependencies_ready = 1;
+            waiting.pending.dependencies_ok = waiting.failed ? 0 : 1;
+            PushLoad( rsm, waiting.pending );
+        }
+        else
+        {
+            hash::set( rsm->deps_waiting, key, waiting );
         }
     }
+    multi_hash::remove_all( rsm->deps_dependants, (uint64_t)id.hash );
+}
 
-    return RSMImpl::INVALID_LOADER_INDEX;
+static void SetFinalState( RSMImpl* rsm, id_t id, RSMEState::E state )
+{
+    rsm->rstate[id.index].store( state, std::memory_order_release );
+    ResolveDependants( rsm, id, state );
+    NotifyWaiters( rsm );
 }
 
-static void FileLoadCallback( BXIFilesystem* fs, BXFileHandle fhandle, BXEFileStatus::E file_status, void* user_data0, void* user_data1, void* user_data2 )
+// true when 'from' (transitively) waits for 'target'. Only edges to LOADING resources are followed,
+// because finished resources don't wait for anything. Called under deps_lock
+static bool WaitsFor( RSMImpl* rsm, id_t from, id_t target )
 {
-    RSMImpl* rsm = (RSMImpl*)user_data0;
-    id_t id = { (uint32_t)(uintptr_t)user_data1 };
+    small_array_t<id_t, RSMDependencyList::MAX_DEPENDENCIES> stack( rsm->pending_resources_allocator );
+    hash_t<uint8_t> visited( rsm->pending_resources_allocator );
+    array::push_back( stack, from );
+    while( !array::empty( stack ) )
+    {
+        const id_t id = array::back( stack );
+        array::pop_back( stack );
 
-    RSMPendingResource pending = {};
-    pending.id = id;
-    pending.user_system = user_data2;
+        auto* e = multi_hash::find_first( rsm->deps_dependencies, (uint64_t)id.hash );
+        for( ; e; e = multi_hash::find_next( rsm->deps_dependencies, e ) )
+        {
+            const id_t dep = { e->value.i };
+            if( dep.hash == target.hash )
+                return true;
 
-    if( file_status == BXEFileStatus::READY )
+            if( !rsm->IsAlive( dep ) || rsm->rstate[dep.index].load( std::memory_order_acquire ) != RSMEState::LOADING )
+                continue;
+
+            if( hash::has( visited, (uint64_t)dep.hash ) )
+                continue;
+
+            hash::set( visited, (uint64_t)dep.hash, uint8_t( 1 ) );
+            array::push_back( stack, dep );
+        }
+    }
+    return false;
+}
+
+// Returns true when resource has to wait for dependencies. Ownership of pending is taken in that case.
+static bool ScheduleDependencies( RSMImpl* rsm, RSMPendingResource* pending, RSMLoader* loader, const void* data, uint32_t size )
+{
+    RSMDependencyList deps;
+    loader->Dependencies( &deps, data, size, pending->user_system );
+    if( deps.count == 0 )
+        return false;
+
+    RSMResourceID dep_id[RSMDependencyList::MAX_DEPENDENCIES];
+    uint32_t failed = 0;
+    for( uint32_t i = 0; i < deps.count; ++i )
     {
-        pending.hfile = fhandle;
+        const RSMDependencyList::Entry& entry = deps.entry[i];
+        if( entry.path )
+        {
+            void* system = (entry.system) ? entry.system : pending->user_system;
+            dep_id[i] = RSM::Load( entry.path, system );
+        }
+        else
+        {
+            dep_id[i] = RSM::Find( RSMResourceHash{ entry.hash } );
+        }
 
-        scope_mutex_t guard( rsm->to_load_lock );
-        queue::push_back( rsm->to_load, pending );
+        if( !rsm->IsAlive( { dep_id[i].i } ) )
+        {
+            SYS_LOG_ERROR( "Resource (%s) has unknown dependency (%s)", rsm->rname[pending->id.index].c_str(), (entry.path) ? entry.path : "by hash" );
+            failed = 1;
+        }
     }
-    else
+
+    // references taken for edges which would close a cycle are given back, otherwise resources in cycle would keep each other alive
+    RSMResourceID cyclic[RSMDependencyList::MAX_DEPENDENCIES];
+    uint32_t nb_cyclic = 0;
+    uint32_t nb_pending = 0;
+    {
+        scope_mutex_t guard( rsm->deps_lock );
+
+        for( uint32_t i = 0; i < deps.count; ++i )
+        {
+            const id_t id = { dep_id[i].i };
+            if( !rsm->IsAlive( id ) )
+                continue;
+
+            // state is stored before dependants are resolved under deps_lock, so nothing can be missed here
+            const RSMEState::E state = rsm->rstate[id.index].load( std::memory_order_acquire );
+            if( state == RSMEState::LOADING )
+            {
+                if( id.hash == pending->id.hash || WaitsFor( rsm, id, pending->id ) )
+                {
+                    SYS_LOG_ERROR( "Resource (%s) has cyclic dependency (%s)", rsm->rname[pending->id.index].c_str(), rsm->rname[id.index].c_str() );
+                    cyclic[nb_cyclic++] = dep_id[i];
+                    failed = 1;
+                    continue;
+                }
+
+                multi_hash::insert( rsm->deps_dependants, (uint64_t)id.hash, pending->id );
+                nb_pending += 1;
+            }
+            else if( state != RSMEState::READY )
+            {
+                failed = 1;
+            }
+
+            multi_hash::insert( rsm->deps_dependencies, (uint64_t)pending->id.hash, dep_id[i] );
+        }
+
+        pending->dependencies_ready = 1;
+        pending->dependencies_ok = failed ? 0 : 1;
+
+        if( nb_pending )
+        {
+            RSMWaitingResource waiting = {};
+            waiting.pending = *pending;
+            waiting.nb_pending_dependencies = nb_pending;
+            waiting.failed = failed;
+            hash::set( rsm->deps_waiting, (uint64_t)pending->id.hash, waiting );
+        }
+    }
+
+    for( uint32_t i = 0; i < nb_cyclic; ++i )
     {
-        rsm->rstate[id.index] = RSMEState::FAIL;
+        RSM::Release( cyclic[i] );
     }
 
-    rsm->sema.signal();
+    return nb_pending != 0;
 }
 
-static void LookpuInsert( RSMImpl* rsm, RSMResourceHash rhash, id_t id )
+static void ReleaseDependencies( RSMImpl* rsm, id_t id )
 {
-    scope_mutex_t guard( rsm->lookup_lock );
-    SYS_ASSERT( hash::has( rsm->lookup, rhash.h ) == false );
+    small_array_t<RSMResourceID, RSMDependencyList::MAX_DEPENDENCIES> dep_id( rsm->pending_resources_allocator );
+    {
+        scope_mutex_t guard( rsm->deps_lock );
+        auto* e = multi_hash::find_first( rsm->deps_dependencies, (uint64_t)id.hash );
+        for( ; e; e = multi_hash::find_next( rsm->deps_dependencies, e ) )
+        {
+            array::push_back( dep_id, e->value );
+        }
+        multi_hash::remove_all( rsm->deps_dependencies, (uint64_t)id.hash );
+    }
 
-    rsm->rrefcount[id.index] = 1;
-    hash::set( rsm->lookup, rhash.h, id );
+    for( RSMResourceID dep : dep_id )
+    {
+        RSM::Release( dep );
+    }
+}
 
+static inline uint32_t HistogramBucket( uint64_t us )
+{
+    uint32_t bucket = 0;
+    for( uint64_t ms = us / 1000; ms && bucket < RSMLoadStats::HISTOGRAM_SIZE - 1; ms >>= 1 )
+        ++bucket;
+    return bucket;
 }
-static bool LookupRemove( RSMImpl* rsm, RSMResourceHash rhash )
+
+static void RecordLoadStats( RSMImpl* rsm, id_t id, bool ok, uint64_t bytes_read )
 {
-    scope_mutex_t guard( rsm->lookup_lock );
-    SYS_ASSERT( hash::has( rsm->lookup, rhash.h ) == true );
+    const uint32_t index = id.index;
+    const uint64_t now = BXTime::GlobalTimeUS();
+    const RSMLoadTiming& timing = rsm->rtiming[index];
+    
+    // stages which didn't happen (e.g. file not found) take no time
+    const uint64_t io_done = (timing.io_done) ? timing.io_done : now;
+    const uint64_t load_begin = (timing.load_begin) ? timing.load_begin : now;
+
+    RSMSlowLoad load = {};
+    load.io_us = io_done - timing.request;
+    load.queue_us = load_begin - io_done;
+    load.cpu_us = now - load_begin;
+    load.total_us = now - timing.request;
+    load.bytes_read = bytes_read;
+    load.bytes_resident = (ok) ? rsm->rdata[index].size : 0;
+
+    RSMTypeCounters& counters = rsm->type_counters[rsm->rloader_index[index]];
+    counters.nb_loads += 1;
+    counters.nb_failed += (ok) ? 0 : 1;
+    counters.queue_us += load.queue_us;
+    counters.io_us += load.io_us;
+    counters.cpu_us += load.cpu_us;
+    counters.bytes_read += load.bytes_read;
+    counters.bytes_resident += load.bytes_resident;
+    counters.histogram[HistogramBucket( load.total_us )] += 1;
+
+    if( load.total_us <= rsm->slowest_threshold_us.load( std::memory_order_relaxed ) )
+        return;
 
-    const id_t null_id{ 0 };
-    const id_t id = hash::get( rsm->lookup, rhash.h, null_id );
-    if( --rsm->rrefcount[id.index] == 0 )
+    scope_mutex_t guard( rsm->slowest_lock );
+    uint32_t slot = rsm->nb_slowest;
+    if( slot == RSMSlowLoad::MAX_COUNT )
     {
-        hash::remove( rsm->lookup, rhash.h );
-        return true;
+        // replace the fastest one
+        slot = 0;
+        for( uint32_t i = 1; i < rsm->nb_slowest; ++i )
+        {
+            if( rsm->slowest[i].total_us < rsm->slowest[slot].total_us )
+                slot = i;
+        }
+        if( rsm->slowest[slot].total_us >= load.total_us )
+            return;
+    }
+    else
+    {
+        rsm->nb_slowest += 1;
     }
-    return false;
-}
 
-static void LookupAcquire( RSMImpl* rsm, RSMResourceHash rhash, id_t id )
-{
-    scope_mutex_t guard( rsm->lookup_lock );
+    snprintf( load.name, sizeof( load.name ), "%s", rsm->rname[index].c_str() );
+    rsm->slowest[slot] = load;
 
-    const id_t null_id{ 0 };
-    const id_t found_id = hash::get( rsm->lookup, rhash.h, null_id );
-    if( found_id == id )
+    if( rsm->nb_slowest == RSMSlowLoad::MAX_COUNT )
     {
-        rsm->rrefcount[id.index] += 1;
+        uint64_t threshold = UINT64_MAX;
+        for( uint32_t i = 0; i < rsm->nb_slowest; ++i )
+            threshold = min_of_2( threshold, rsm->slowest[i].total_us );
+        rsm->slowest_threshold_us.store( threshold, std::memory_order_relaxed );
     }
 }
 
-static id_t LookupFind( RSMImpl* rsm, RSMResourceHash rhash )
+// Loads run on jobs and io thread, unloads on jobs spawned by Update, so the same slot can be touched by both when resource
+// is released while loading. Load stage marks slot busy before it checks id. Release invalidates id before unload checks
+// busy, so either load sees dead id and leaves slot alone, or unload sees busy slot and is deferred.
+static bool BeginLoadStage( RSMImpl* rsm, id_t id )
 {
-    const id_t null_id{ 0 };
+    rsm->rbusy[id.index].fetch_add( 1, std::memory_order_seq_cst );
+    if( rsm->IsAlive( id ) )
+        return true;
 
-    scope_mutex_t guard( rsm->lookup_lock );
-    const id_t result = hash::get( rsm->lookup, rhash.h, null_id );
-    if( result.hash != null_id.hash )
+    rsm->rbusy[id.index].fetch_sub( 1, std::memory_order_release );
+    return false;
+}
+static void EndLoadStage( RSMImpl* rsm, id_t id )
+{
+    rsm->rbusy[id.index].fetch_sub( 1, std::memory_order_release );
+}
+
+static void ProcessReload( RSMImpl* rsm, RSMPendingResource pending )
+{
+    RSMReloadedResource result = {};
+    result.id = pending.id;
+
+    bool should_delete_file_data = true;
+    if( rsm->IsAlive( pending.id ) )
     {
-        rsm->rrefcount[result.index] += 1;
+        BXFile file = {};
+        rsm->filesystem->File( &file, pending.hfile );
+
+        result.loader_index = rsm->rloader_index[pending.id.index];
+        RSMLoader* loader = rsm->loader[result.loader_index];
+        result.ok = loader->Load( &result.data, file.pointer, file.size, file.allocator, pending.user_system ) ? 1 : 0;
+        should_delete_file_data = !result.ok || (result.data.pointer != file.pointer);
     }
-    return result;
+    rsm->filesystem->CloseFile( &pending.hfile, should_delete_file_data );
+
+    // new data is swapped in on main thread, between frames
+    scope_mutex_t guard( rsm->reloaded_lock );
+    queue::push_back( rsm->reloaded, result );
 }
 
-RSMResourceID RSM::Load( const char* relative_path, void* system )
+static void ProcessLoad( RSMImpl* rsm, RSMPendingResource pending )
 {
-    RSMResourceID result = { 0 };
-    
-    const RSMResourceHash rhash = CreateHash( relative_path );
-    const id_t found_id = LookupFind( _rsm, rhash );
-    if( found_id.hash )
+    if( pending.reload )
     {
-        return { found_id.hash };
+        ProcessReload( rsm, pending );
+        return;
     }
 
-    const uint8_t loader_index = FindLoader( _rsm, rhash );
-    if( loader_index != RSMImpl::INVALID_LOADER_INDEX )
+    if( pending.streamed )
     {
-        id_t id = { 0 };
+        if( BeginLoadStage( rsm, pending.id ) )
         {
-            scope_mutex_t guard( _rsm->id_lock );
-            id = id_table::create( _rsm->id_alloc );
-        }
-    
-        LookpuInsert( _rsm, rhash, id );
-
-        const uint32_t index = id.index;
-        string::create( &_rsm->rname[index], relative_path, _rsm->string_allocator );
-        _rsm->rhash[index] = rhash;
-        _rsm->rid[index] = id;
-        _rsm->rloader_index[index] = loader_index;
-        _rsm->rstate[index] = RSMEState::LOADING;
-        _rsm->rflags[index] = RSMEInternalState::MANAGED;
-        
-        SYS_ASSERT( _rsm->rdata[index].pointer == nullptr );
+            rsm->rtiming[pending.id.index].load_begin = BXTime::GlobalTimeUS();
 
+            RSMResourceData* data = &rsm->rdata[pending.id.index];
+            RSMStreamingLoader* loader = rsm->loader[rsm->rloader_index[pending.id.index]]->Streaming();
+            const bool load_ok = loader->StreamEnd( data, pending.stream_ok != 0, pending.user_system );
+            
+            BXFile file = {};
+            rsm->filesystem->File( &file, pending.hfile );
+            RecordLoadStats( rsm, pending.id, load_ok, file.size );
+            
+            if( load_ok )
+            {
+                SetFinalState( rsm, pending.id, RSMEState::READY );
+            }
+            else
+            {
+                SYS_LOG_ERROR( "Resource failed to load (%s)", rsm->rname[pending.id.index].c_str() );
+                SetFinalState( rsm, pending.id, RSMEState::FAIL );
+            }
+            EndLoadStage( rsm, pending.id );
+        }
+        rsm->filesystem->CloseFile( &pending.hfile, false );
+        return;
+    }
+
+    bool should_delete_file_data = false;
+    if( BeginLoadStage( rsm, pending.id ) )
+    {
+        BXFile file = {};
+        BXEFileStatus::E status = rsm->filesystem->File( &file, pending.hfile );
+        SYS_ASSERT( status == BXEFileStatus::READY );
+
+        RSMResourceData* data = &rsm->rdata[pending.id.index];
+
+        const uint32_t loader_index = rsm->rloader_index[pending.id.index];
+        RSMLoader* loader = rsm->loader[loader_index];
+        if( !pending.dependencies_ready && ScheduleDependencies( rsm, &pending, loader, file.pointer, file.size ) )
+        {
+            // file stays open until all dependencies are done
+            EndLoadStage( rsm, pending.id );
+            return;
+        }
+
+        rsm->rtiming[pending.id.index].load_begin = BXTime::GlobalTimeUS();
+
+        bool load_ok = false;
+        if( pending.dependencies_ok || !pending.dependencies_ready )
+        {
+            load_ok = loader->Load( data, file.pointer, file.size, file.allocator, pending.user_system );
+        }
+        else
+        {
+            SYS_LOG_ERROR( "Dependency of resource (%s) failed", rsm->rname[pending.id.index].c_str() );
+        }
+        RecordLoadStats( rsm, pending.id, load_ok, file.size );
+
+        if( load_ok )
+        {
+            SetFinalState( rsm, pending.id, RSMEState::READY );
+        }
+        else
+        {
+            SYS_LOG_ERROR( "Resource failed to load (%s)", rsm->rname[pending.id.index].c_str() );
+            SetFinalState( rsm, pending.id, RSMEState::FAIL );
+        }
+
+        should_delete_file_data = !load_ok || (data->pointer != file.pointer);
+        EndLoadStage( rsm, pending.id );
+    }
+    rsm->filesystem->CloseFile( &pending.hfile, should_delete_file_data );
+}
+
+static void ProcessUnload( RSMImpl* rsm, const RSMPendingResource& pending )
+{
+    if( rsm->IsAlive( pending.id ) )
+    {
+        if( rsm->rbusy[pending.id.index].load( std::memory_order_seq_cst ) != 0 )
+        {
+            // load is still writing rdata. Tried again on next Update
+            PushToUnloadRing( rsm, pending );
+            return;
+        }
+
+        SYS_ASSERT( RefCount( rsm, pending.id.index ) == 0 );
+
+        const uint32_t loader_index = rsm->rloader_index[pending.id.index];
+        RSMLoader* loader = rsm->loader[loader_index];
+        
+        RSMResourceData* data = &rsm->rdata[pending.id.index];                
+        rsm->type_counters[loader_index].bytes_resident -= data->size;
+        loader->Unload( data );
+        ReleaseDependencies( rsm, pending.id );
+        if( data->allocator )
+        {
+            BX_FREE( data->allocator, (void*)data->pointer );
+        }
+
+        RemoveResourceEntry( rsm, pending.id );
+    }
+}
+
+static inline RSMLoader* PendingLoader( RSMImpl* rsm, const RSMPendingResource& pending, uint32_t* loader_index )
+{
+    if( !rsm->IsAlive( pending.id ) )
+        return nullptr;
+
+    loader_index[0] = rsm->rloader_index[pending.id.index];
+    return rsm->loader[loader_index[0]];
+}
+
+static void JobFinished( RSMImpl* rsm )
+{
+    if( --rsm->nb_jobs_in_flight == 0 )
+    {
+        std::lock_guard<std::mutex> guard( rsm->jobs_lock );
+        rsm->jobs_done_cv.notify_all();
+    }
+}
+
+// returns false when loader has reached its concurrency limit. Called only from background thread
+static bool DispatchLoad( RSMImpl* rsm, const RSMPendingResource& pending )
+{
+    uint32_t loader_index = 0;
+    RSMLoader* loader = PendingLoader( rsm, pending, &loader_index );
+    if( !loader )
+    {
+        ProcessLoad( rsm, pending );
+        return true;
+    }
+
+    if( loader->MainThreadOnly() )
+    {
+        scope_mutex_t guard( rsm->main_thread_load_lock );
+        queue::push_back( rsm->main_thread_load, pending );
+        return true;
+    }
+
+    const uint32_t limit = loader->MaxConcurrentLoads();
+    if( limit && rsm->loader_in_flight[loader_index].load() >= limit )
+        return false;
+
+    rsm->loader_in_flight[loader_index] += 1;
+    rsm->nb_jobs_in_flight += 1;
+
+    JOBTaskID task = JOB::Create( "RSMLoad", [rsm, pending, loader_index, limit]( const JOBRange range, const JOBContext& ctx )
+    {
+        ProcessLoad( rsm, pending );
+        rsm->loader_in_flight[loader_index] -= 1;
+        if( limit )
+        {
+            // wake up background thread, so deferred loads can be dispatched
+            rsm->sema.signal();
+        }
+        JobFinished( rsm );
+    } );
+    JOB::Spawn( task );
+    return true;
+}
+
+static void BackgroundThread( RSMImpl* rsm )
+{
+    while( rsm->is_running )
+    {
+        rsm->sema.wait();
+
+        // loads which hit loader concurrency limit last time go first. Each queue stops at first load
+        // which doesn't fit, so wake up costs only what is dispatched
+        for( uint32_t i = 0; i < rsm->nb_loaders; ++i )
+        {
+            queue_t<RSMPendingResource>& deferred = rsm->deferred_load[i];
+            while( !queue::empty( deferred ) && DispatchLoad( rsm, queue::front( deferred ) ) )
+            {
+                queue::pop_front( deferred );
+            }
+        }
+
+        // loader with non empty deferred queue is at its limit, so new loads for it are queued behind in order
+        RSMPendingResource pending = {};
+        while( rsm->to_load.pop( &pending ) )
+        {
+            if( !DispatchLoad( rsm, pending ) )
+            {
+                queue::push_back( rsm->deferred_load[rsm->rloader_index[pending.id.index]], pending );
+            }
+        }
+    }
+}
+
+static uint8_t FindLoader( RSMImpl* impl, RSMResourceHash rhash )
+{
+    const RSMResourceHashDecoder rhash_decoded = { rhash.h };
+
+    for( uint32_t i = 0; i < impl->nb_loaders; ++i )
+    {
+        if( rhash_decoded.type == impl->loader_supported_type[i] )
         {
-            BXPostLoadCallback post_load_cb( FileLoadCallback, _rsm, (void*)(uintptr_t)id.hash, system );
+            return uint8_t( i );
+        }
+    }
+
+    return RSMImpl::INVALID_LOADER_INDEX;
+}
+
+static void FileLoadCallback( BXIFilesystem* fs, BXFileHandle fhandle, BXEFileStatus::E file_status, void* user_data0, void* user_data1, void* user_data2 )
+{
+    RSMImpl* rsm = (RSMImpl*)user_data0;
+    id_t id = { (uint32_t)(uintptr_t)user_data1 };
+
+    RSMPendingResource pending = {};
+    pending.id = id;
+    pending.user_system = user_data2;
+
+    rsm->rtiming[id.index].io_done = BXTime::GlobalTimeUS();
+    if( file_status == BXEFileStatus::READY )
+    {
+        pending.hfile = fhandle;
+        PushToLoadRing( rsm, pending );
+    }
+    else
+    {
+        RecordLoadStats( rsm, id, false, 0 );
+        SetFinalState( rsm, id, RSMEState::FAIL );
+    }
+
+    rsm->sema.signal();
+}
+
+// ids follow file handles of batch
+struct RSMFileBatch
+{
+    RSMImpl* rsm;
+    void* system;
+    uint32_t count;
+    id_t ids[1];
+};
+
+static void FileBatchLoadCallback( BXIFilesystem* fs, const BXFileHandle* hfiles, uint32_t count, void* user_data0, void* user_data1, void* user_data2 )
+{
+    RSMFileBatch* batch = (RSMFileBatch*)user_data0;
+    SYS_ASSERT( batch->count == count );
+
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        BXFile file = {};
+        const BXEFileStatus::E file_status = fs->File( &file, hfiles[i] );
+        FileLoadCallback( fs, hfiles[i], file_status, batch->rsm, (void*)(uintptr_t)batch->ids[i].hash, batch->system );
+    }
+
+    BX_FREE( batch->rsm->pending_resources_allocator, batch );
+}
+
+static void FileReloadCallback( BXIFilesystem* fs, BXFileHandle fhandle, BXEFileStatus::E file_status, void* user_data0, void* user_data1, void* user_data2 )
+{
+    RSMImpl* rsm = (RSMImpl*)user_data0;
+
+    RSMPendingResource pending = {};
+    pending.id = { (uint32_t)(uintptr_t)user_data1 };
+    pending.user_system = user_data2;
+    pending.hfile = fhandle;
+    pending.reload = 1;
+
+    if( file_status == BXEFileStatus::READY )
+    {
+        PushLoad( rsm, pending );
+    }
+    else
+    {
+        fs->CloseFile( &fhandle, true );
+
+        RSMReloadedResource result = {};
+        result.id = pending.id;
+        scope_mutex_t guard( rsm->reloaded_lock );
+        queue::push_back( rsm->reloaded, result );
+    }
+}
+
+static bool FileStreamChunkCallback( BXIFilesystem* fs, BXFileHandle fhandle, const void* chunk, uint32_t chunk_size, uint32_t offset, uint32_t total_size, void* user_data0, void* user_data1, void* user_data2 )
+{
+    RSMImpl* rsm = (RSMImpl*)user_data0;
+    id_t id = { (uint32_t)(uintptr_t)user_data1 };
+    if( !BeginLoadStage( rsm, id ) )
+        return false;
+
+    RSMResourceData* data = &rsm->rdata[id.index];
+    RSMStreamingLoader* loader = rsm->loader[rsm->rloader_index[id.index]]->Streaming();
+    bool ok = offset != 0 || loader->StreamBegin( data, total_size, rsm->default_resource_allocator, user_data2 );
+    ok = ok && loader->StreamChunk( data, chunk, chunk_size, offset, user_data2 );
+    EndLoadStage( rsm, id );
+    return ok;
+}
+
+static void FileStreamDoneCallback( BXIFilesystem* fs, BXFileHandle fhandle, BXEFileStatus::E file_status, void* user_data0, void* user_data1, void* user_data2 )
+{
+    RSMImpl* rsm = (RSMImpl*)user_data0;
+
+    RSMPendingResource pending = {};
+    pending.id = { (uint32_t)(uintptr_t)user_data1 };
+    pending.hfile = fhandle;
+    pending.user_system = user_data2;
+    pending.streamed = 1;
+    pending.stream_ok = (file_status == BXEFileStatus::READY) ? 1 : 0;
+    rsm->rtiming[pending.id.index].io_done = BXTime::GlobalTimeUS();
+    PushLoad( rsm, pending );
+}
+
+static void LruLink( RSMImpl* rsm, uint32_t index )
+{
+    rsm->rlru_prev[index] = RSM_LRU_NULL;
+    rsm->rlru_next[index] = rsm->lru_head;
+    if( rsm->lru_head != RSM_LRU_NULL )
+        rsm->rlru_prev[rsm->lru_head] = index;
+    else
+        rsm->lru_tail = index;
+
+    rsm->lru_head = index;
+    rsm->lru_bytes += rsm->rdata[index].size;
+    rsm->lru_count += 1;
+}
+static void LruUnlink( RSMImpl* rsm, uint32_t index )
+{
+    const uint32_t prev = rsm->rlru_prev[index];
+    const uint32_t next = rsm->rlru_next[index];
+    if( prev != RSM_LRU_NULL )
+        rsm->rlru_next[prev] = next;
+    else
+        rsm->lru_head = next;
+
+    if( next != RSM_LRU_NULL )
+        rsm->rlru_prev[next] = prev;
+    else
+        rsm->lru_tail = prev;
+
+    rsm->rlru_prev[index] = RSM_LRU_NULL;
+    rsm->rlru_next[index] = RSM_LRU_NULL;
+    rsm->lru_bytes -= rsm->rdata[index].size;
+    rsm->lru_count -= 1;
+}
+
+// refcount of resource has reached zero. Returns true when resource has been cached instead of removed
+static inline bool LruIsLinked( const RSMImpl* rsm, uint32_t index )
+{
+    return rsm->lru_head == index || rsm->rlru_prev[index] != RSM_LRU_NULL;
+}
+
+static bool LruCache( RSMImpl* rsm, id_t id )
+{
+    if( LruIsLinked( rsm, id.index ) )
+        return true;
+
+    const bool cacheable = (rsm->rflags[id.index] & RSMEInternalState::MANAGED)
+        && rsm->rstate[id.index] == RSMEState::READY
+        && rsm->lru_budget != 0
+        && rsm->rdata[id.index].size <= rsm->lru_budget;
+    if( !cacheable )
+        return false;
+
+    LruLink( rsm, id.index );
+    return true;
+}
+
+static inline bool LruOverBudget( const RSMImpl* rsm )
+{
+    // zero sized resources don't add bytes, so zero budget has to evict by count
+    const uint32_t max_count = (rsm->lru_budget) ? RSM_MAX_CACHED : 0;
+    return rsm->lru_bytes > rsm->lru_budget || rsm->lru_count > max_count;
+}
+
+// removes least recently used resources from lookup until cache fits in budget (bytes and entries). Returns number of evicted ids
+static uint32_t LruEvict( RSMImpl* rsm, id_t* evicted, uint32_t max_evicted )
+{
+    uint32_t count = 0;
+    while( LruOverBudget( rsm ) && rsm->lru_tail != RSM_LRU_NULL && count < max_evicted )
+    {
+        const uint32_t index = rsm->lru_tail;
+        LruUnlink( rsm, index );
+        rsm->lookup.Remove( rsm->rhash[index].h );
+        evicted[count++] = rsm->rid[index];
+    }
+    return count;
+}
 
-            RSMLoader* loader = _rsm->loader[loader_index];
-            BXEFIleMode::E mode = (loader->IsBinary()) ? BXEFIleMode::BIN : BXEFIleMode::TXT;
-            _rsm->filesystem->LoadFile( relative_path, mode, post_load_cb, _rsm->default_resource_allocator );
+static void LookupRevive( RSMImpl* rsm, id_t id );
+
+// returns id of resource which ended up in lookup. When other thread has inserted the same resource first,
+// its id is returned (with reference added) and 'id' has to be destroyed by caller
+static id_t LookupInsertLocked( RSMImpl* rsm, RSMResourceHash rhash, id_t id )
+{
+    const id_t existing = rsm->lookup.Find( rhash.h );
+    if( existing.hash )
+    {
+        LookupRevive( rsm, existing );
+        return existing;
+    }
+
+    rsm->rrefcount[id.index].store( RefPack( id, 1 ), std::memory_order_release );
+    rsm->rlru_prev[id.index] = RSM_LRU_NULL;
+    rsm->rlru_next[id.index] = RSM_LRU_NULL;
+    RSMLookupTable::Table* old_table = rsm->lookup.Set( rhash.h, id );
+    if( old_table )
+    {
+        array::push_back( rsm->retired_lookup, old_table );
+    }
+    return id;
+}
+static id_t LookpuInsert( RSMImpl* rsm, RSMResourceHash rhash, id_t id )
+{
+    scope_mutex_t guard( rsm->lookup_lock );
+    return LookupInsertLocked( rsm, rhash, id );
+}
+
+namespace RSMELookupRemove
+{
+    enum E
+    {
+        REFERENCED, // still referenced (or somebody else takes care of it)
+        CACHED,     // not referenced, but kept loaded
+        REMOVED,    // has to be destroyed
+    };
+}
+
+// returns true when last reference has been dropped and LookupRemoveLocked has to be called
+static inline bool LookupDropRef( RSMImpl* rsm, id_t id )
+{
+    const uint32_t prev = rsm->rrefcount[id.index].fetch_sub( 1, std::memory_order_acq_rel );
+    SYS_ASSERT( (prev & 0xFFFF) != 0 );
+    return (prev & 0xFFFF) == 1;
+}
+
+// has to be called with lookup_lock held
+static RSMELookupRemove::E LookupRemoveLocked( RSMImpl* rsm, RSMResourceHash rhash, id_t id )
+{
+    // resource could be revived, or released again and already handled, before we got the lock
+    if( !(rsm->lookup.Find( rhash.h ) == id) || RefCount( rsm, id.index ) != 0 )
+        return RSMELookupRemove::REFERENCED;
+
+    if( LruCache( rsm, id ) )
+        return RSMELookupRemove::CACHED;
+
+    rsm->lookup.Remove( rhash.h );
+    return RSMELookupRemove::REMOVED;
+}
+
+static RSMELookupRemove::E LookupRemove( RSMImpl* rsm, RSMResourceHash rhash, id_t id )
+{
+    if( !LookupDropRef( rsm, id ) )
+        return RSMELookupRemove::REFERENCED;
+
+    scope_mutex_t guard( rsm->lookup_lock );
+    return LookupRemoveLocked( rsm, rhash, id );
+}
+
+// slow path. Has to be called with lookup_lock held
+static void LookupRevive( RSMImpl* rsm, id_t id )
+{
+    if( RefCount( rsm, id.index ) == 0 && LruIsLinked( rsm, id.index ) )
+    {
+        LruUnlink( rsm, id.index );
+    }
+    rsm->rrefcount[id.index].fetch_add( 1, std::memory_order_acq_rel );
+}
+
+static void LookupAcquire( RSMImpl* rsm, RSMResourceHash rhash, id_t id )
+{
+    if( TryAddRef( rsm, id ) )
+        return;
+
+    scope_mutex_t guard( rsm->lookup_lock );
+    if( rsm->lookup.Find( rhash.h ) == id )
+    {
+        LookupRevive( rsm, id );
+    }
+}
+
+static id_t LookupFind( RSMImpl* rsm, RSMResourceHash rhash )
+{
+    const id_t result = rsm->lookup.Find( rhash.h );
+    if( result.hash == 0 || TryAddRef( rsm, result ) )
+        return result;
+
+    scope_mutex_t guard( rsm->lookup_lock );
+    const id_t locked_result = rsm->lookup.Find( rhash.h );
+    if( locked_result.hash )
+    {
+        LookupRevive( rsm, locked_result );
+    }
+    return locked_result;
+}
+
+static void QueueUnloads( RSMImpl* rsm, id_t* ids, uint32_t count )
+{
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        rsm->rstate[ids[i].index] = RSMEState::UNLOADING;
+    }
+    {
+        scope_mutex_t guard( rsm->id_lock );
+        for( uint32_t i = 0; i < count; ++i )
+        {
+            ids[i] = id_table::invalidate( rsm->id_alloc, ids[i] );
+        }
+    }
+    // pairs with BeginLoadStage: invalidated id is visible before ProcessUnload reads rbusy
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    NotifyWaiters( rsm );
+
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        RSMPendingResource pending = {};
+        pending.id = ids[i];
+        PushToUnloadRing( rsm, pending );
+    }
+}
+static void QueueUnload( RSMImpl* rsm, id_t id )
+{
+    QueueUnloads( rsm, &id, 1 );
+}
+
+static void EvictCached( RSMImpl* rsm )
+{
+    id_t evicted[64];
+    uint32_t nb_evicted = 0;
+    do
+    {
+        {
+            scope_mutex_t guard( rsm->lookup_lock );
+            nb_evicted = LruEvict( rsm, evicted, 64 );
+        }
+        QueueUnloads( rsm, evicted, nb_evicted );
+    } while( nb_evicted );
+}
+
+// has to be called with record_lock held
+static void RecordLoadLocked( RSMImpl* rsm, const char* relative_path, RSMResourceHash rhash )
+{
+    if( !rsm->is_recording || hash::has( rsm->record_seen, rhash.h ) )
+        return;
+
+    hash::set( rsm->record_seen, rhash.h, uint8_t( 1 ) );
+
+    char line[320];
+    const int len = snprintf( line, sizeof( line ), "%llu %s", BXTime::GlobalTimeMS() - rsm->record_start_ms, relative_path );
+    if( len > 0 && len < (int)sizeof( line ) )
+    {
+        string::appendn( &rsm->record, line, (unsigned)len, '\n' );
+    }
+}
+static void RecordLoad( RSMImpl* rsm, const char* relative_path, RSMResourceHash rhash )
+{
+    scope_mutex_t guard( rsm->record_lock );
+    RecordLoadLocked( rsm, relative_path, rhash );
+}
+
+static void UpdatePrefetch( RSMImpl* rsm )
+{
+    // resources are released as soon as they finish, so they wait in cache for first real Load
+    for( int32_t i = (int32_t)array::size( rsm->prefetch_in_flight ) - 1; i >= 0; --i )
+    {
+        const RSMResourceID id = rsm->prefetch_in_flight[i];
+        if( RSM::State( id ) != RSMEState::LOADING )
+        {
+            RSM::Release( id );
+            array::erase_swap( rsm->prefetch_in_flight, i );
+        }
+    }
+
+    while( !rsm->prefetch_it.null() && array::size( rsm->prefetch_in_flight ) < RSM_PREFETCH_MAX_IN_FLIGHT )
+    {
+        const RSMResourceID id = RSM::Load( rsm->prefetch_it.pointer, rsm->prefetch_system );
+        if( RSM::IsAlive( id ) )
+        {
+            array::push_back( rsm->prefetch_in_flight, id );
+        }
+        rsm->prefetch_it = string::iterate( rsm->prefetch, rsm->prefetch_it );
+    }
+}
+
+static void InitLoadEntry( RSMImpl* rsm, id_t id, const char* relative_path, RSMResourceHash rhash, uint8_t loader_index, void* system )
+{
+    const uint32_t index = id.index;
+    rsm->rname[index] = string_interner::intern( relative_path );
+    rsm->rhash[index] = rhash;
+    rsm->rid[index] = id;
+    rsm->rloader_index[index] = loader_index;
+    rsm->rstate[index] = RSMEState::LOADING;
+    rsm->rflags[index] = RSMEInternalState::MANAGED;
+    rsm->rsystem[index] = system;
+    rsm->rtiming[index] = {};
+    rsm->rtiming[index].request = BXTime::GlobalTimeUS();
+    SYS_ASSERT( rsm->rdata[index].pointer == nullptr );
+}
+
+static void IssueFileRequest( RSMImpl* rsm, id_t id, const char* relative_path, void* system )
+{
+    RSMLoader* loader = rsm->loader[rsm->rloader_index[id.index]];
+    if( RSMStreamingLoader* streaming = loader->Streaming() )
+    {
+        BXStreamChunkCallback chunk_cb( FileStreamChunkCallback, rsm, (void*)(uintptr_t)id.hash, system );
+        BXPostLoadCallback post_load_cb( FileStreamDoneCallback, rsm, (void*)(uintptr_t)id.hash, system );
+        rsm->filesystem->StreamFile( relative_path, streaming->ChunkSize(), chunk_cb, post_load_cb, rsm->default_resource_allocator );
+    }
+    else
+    {
+        BXPostLoadCallback post_load_cb( FileLoadCallback, rsm, (void*)(uintptr_t)id.hash, system );
+
+        BXEFIleMode::E mode = (loader->IsBinary()) ? BXEFIleMode::BIN : BXEFIleMode::TXT;
+        rsm->filesystem->LoadFile( relative_path, mode, post_load_cb, rsm->default_resource_allocator );
+    }
+}
+
+RSMResourceID RSM::Load( const char* relative_path, void* system )
+{
+    RSMResourceID result = { 0 };
+    
+    const RSMResourceHash rhash = CreateHash( relative_path );
+    const id_t found_id = LookupFind( _rsm, rhash );
+    if( found_id.hash )
+    {
+        return { found_id.hash };
+    }
+
+    const uint8_t loader_index = FindLoader( _rsm, rhash );
+    if( loader_index != RSMImpl::INVALID_LOADER_INDEX )
+    {
+        const id_t id = CreateResourceEntry( _rsm );
+        InitLoadEntry( _rsm, id, relative_path, rhash, loader_index, system );
+
+        // entry has to be complete before it can be found by other threads (e.g. loaders resolving dependencies)
+        const id_t inserted_id = LookpuInsert( _rsm, rhash, id );
+        if( !(inserted_id == id) )
+        {
+            RemoveResourceEntry( _rsm, id );
+            return { inserted_id.hash };
+        }
+
+        if( _rsm->is_recording )
+        {
+            RecordLoad( _rsm, relative_path, rhash );
+        }
+        
+        IssueFileRequest( _rsm, id, relative_path, system );
+        result.i = id.hash;
+    }
+
+    return result;
+}
+
+// Sends non streamed resources to filesystem as one batch per file mode. Streamed resources are requested one by one
+static void IssueFileRequests( RSMImpl* rsm, const id_t* ids, const uint32_t* path_indices, uint32_t count, const char* const* relative_paths, void* system, const char** paths, BXFileHandle* hfiles )
+{
+    const uint32_t batch_size = sizeof( RSMFileBatch ) + (count - 1) * sizeof( id_t );
+    for( uint32_t mode_index = 0; mode_index < 2; ++mode_index )
+    {
+        const BXEFIleMode::E mode = (mode_index == 0) ? BXEFIleMode::BIN : BXEFIleMode::TXT;
+
+        RSMFileBatch* batch = (RSMFileBatch*)BX_MALLOC( rsm->pending_resources_allocator, batch_size, ALIGNOF( RSMFileBatch ) );
+        batch->rsm = rsm;
+        batch->system = system;
+        batch->count = 0;
+
+        for( uint32_t i = 0; i < count; ++i )
+        {
+            const id_t id = ids[i];
+            const char* path = relative_paths[path_indices[i]];
+            RSMLoader* loader = rsm->loader[rsm->rloader_index[id.index]];
+            if( loader->Streaming() )
+            {
+                if( mode_index == 0 )
+                {
+                    IssueFileRequest( rsm, id, path, system );
+                }
+            }
+            else if( ((loader->IsBinary()) ? BXEFIleMode::BIN : BXEFIleMode::TXT) == mode )
+            {
+                paths[batch->count] = path;
+                batch->ids[batch->count++] = id;
+            }
+        }
+
+        // batch is freed by FileBatchLoadCallback
+        if( batch->count && rsm->filesystem->LoadFiles( hfiles, paths, batch->count, mode, BXPostLoadBatchCallback( FileBatchLoadCallback, batch ), rsm->default_resource_allocator ) )
+            continue;
+
+        // filesystem is out of handles for whole batch. Fall back to single requests
+        for( uint32_t i = 0; i < batch->count; ++i )
+        {
+            IssueFileRequest( rsm, batch->ids[i], paths[i], system );
+        }
+        BX_FREE( rsm->pending_resources_allocator, batch );
+    }
+}
+
+uint32_t RSM::LoadBatch( RSMResourceID* out_ids, const char* const* relative_paths, uint32_t count, void* system )
+{
+    if( !count )
+        return 0;
+
+    RSMImpl* rsm = _rsm;
+
+    const uint32_t item_size = sizeof( RSMResourceHash ) + sizeof( const char* ) + sizeof( id_t ) * 2 + sizeof( uint32_t ) + sizeof( BXFileHandle ) + sizeof( uint8_t );
+    uint8_t* memory = (uint8_t*)BX_MALLOC( rsm->pending_resources_allocator, count * item_size, 8 );
+    RSMResourceHash* rhashes = (RSMResourceHash*)memory;
+    const char** paths = (const char**)(rhashes + count);
+    id_t* ids = (id_t*)(paths + count);
+    id_t* removed = ids + count;
+    uint32_t* path_indices = (uint32_t*)(removed + count);
+    BXFileHandle* hfiles = (BXFileHandle*)(path_indices + count);
+    uint8_t* loader_indices = (uint8_t*)(hfiles + count);
+
+    // referenced resources are found without locks. The rest gets new entries
+    uint32_t nb_missing = 0;
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        out_ids[i] = RSMResourceID::Null();
+
+        const RSMResourceHash rhash = CreateHash( relative_paths[i] );
+        const id_t found_id = rsm->lookup.Find( rhash.h );
+        if( found_id.hash && TryAddRef( rsm, found_id ) )
+        {
+            out_ids[i].i = found_id.hash;
+            continue;
+        }
+
+        const uint8_t loader_index = FindLoader( rsm, rhash );
+        if( loader_index == RSMImpl::INVALID_LOADER_INDEX )
+            continue;
+
+        rhashes[nb_missing] = rhash;
+        loader_indices[nb_missing] = loader_index;
+        path_indices[nb_missing] = i;
+        ++nb_missing;
+    }
+
+    // cached resources and duplicates within batch get entries too. Insert finds them and these entries are removed
+    CreateResourceEntries( rsm, ids, nb_missing );
+    for( uint32_t i = 0; i < nb_missing; ++i )
+    {
+        InitLoadEntry( rsm, ids[i], relative_paths[path_indices[i]], rhashes[i], loader_indices[i], system );
+    }
+
+    uint32_t nb_new = 0;
+    uint32_t nb_removed = 0;
+    {
+        scope_mutex_t guard( rsm->lookup_lock );
+        for( uint32_t i = 0; i < nb_missing; ++i )
+        {
+            const id_t inserted_id = LookupInsertLocked( rsm, rhashes[i], ids[i] );
+            out_ids[path_indices[i]].i = inserted_id.hash;
+            if( inserted_id == ids[i] )
+            {
+                rhashes[nb_new] = rhashes[i];
+                path_indices[nb_new] = path_indices[i];
+                ids[nb_new++] = inserted_id;
+            }
+            else
+            {
+                removed[nb_removed++] = ids[i];
+            }
+        }
+    }
+
+    if( nb_removed )
+    {
+        RemoveResourceEntries( rsm, removed, nb_removed );
+    }
+
+    if( rsm->is_recording )
+    {
+        scope_mutex_t guard( rsm->record_lock );
+        for( uint32_t i = 0; i < nb_new; ++i )
+        {
+            RecordLoadLocked( rsm, relative_paths[path_indices[i]], rhashes[i] );
         }
+    }
 
-        result.i = id.hash;
+    if( nb_new )
+    {
+        IssueFileRequests( rsm, ids, path_indices, nb_new, relative_paths, system, paths, hfiles );
     }
 
-    return result;
+    BX_FREE( rsm->pending_resources_allocator, memory );
+
+    uint32_t nb_valid = 0;
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        nb_valid += out_ids[i].i != 0;
+    }
+    return nb_valid;
 }
 
 RSMResourceID RSM::Create( const char* name, const void* data )
@@ -355,16 +1706,10 @@ RSMResourceID RSM::Create( const char* name, const void* data )
         return { found_id.hash };
     }
 
-    id_t id = { 0 };
-    {
-        scope_mutex_t guard( _rsm->id_lock );
-        id = id_table::create( _rsm->id_alloc );
-    }
-
-    LookpuInsert( _rsm, rhash, id );
+    const id_t id = CreateResourceEntry( _rsm );
 
     const uint32_t index = id.index;
-    string::create( &_rsm->rname[index], name, _rsm->string_allocator );
+    _rsm->rname[index] = string_interner::intern( name );
     _rsm->rhash[index] = rhash;
     _rsm->rid[index] = id;
     _rsm->rflags[index] = 0;
@@ -376,7 +1721,13 @@ RSMResourceID RSM::Create( const char* name, const void* data )
 
     _rsm->rstate[index] = RSMEState::READY;
 
-    return { id.hash };
+    const id_t inserted_id = LookpuInsert( _rsm, rhash, id );
+    if( !(inserted_id == id) )
+    {
+        RemoveResourceEntry( _rsm, id );
+    }
+
+    return { inserted_id.hash };
 }
 
 RSMResourceID RSM::Create( const void* data )
@@ -386,18 +1737,63 @@ RSMResourceID RSM::Create( const void* data )
     return Create( buff, data );
 }
 
-RSMEState::E RSM::Wait( RSMResourceID rid )
+static inline bool IsDone( const RSMImpl* rsm, id_t id )
+{
+    // released resource is done from waiter's point of view
+    return !rsm->IsAlive( id ) || rsm->rstate[id.index].load( std::memory_order_acquire ) != RSMEState::LOADING;
+}
+
+template< typename Tpred >
+static bool WaitForCondition( RSMImpl* rsm, uint32_t timeout_ms, Tpred pred )
 {
-    id_t id = { rid.i };
-    if( !_rsm->IsAlive( id ) )
+    if( pred() )
+        return true;
+
+    std::unique_lock<std::mutex> guard( rsm->wait_lock );
+    if( timeout_ms == RSM_WAIT_INFINITE )
     {
-        return RSMEState::FAIL;
+        rsm->wait_cv.wait( guard, pred );
+        return true;
     }
+    return rsm->wait_cv.wait_for( guard, std::chrono::milliseconds( timeout_ms ), pred );
+}
+
+RSMEState::E RSM::Wait( RSMResourceID rid, uint32_t timeout_ms )
+{
+    const id_t id = { rid.i };
+    WaitForCondition( _rsm, timeout_ms, [id]() { return IsDone( _rsm, id ); } );
+    return State( rid );
+}
 
-    while( _rsm->rstate[id.index] == RSMEState::LOADING )
-    {}
+bool RSM::WaitAll( const RSMResourceID* rids, uint32_t count, uint32_t timeout_ms )
+{
+    uint32_t nb_done = 0;
+    return WaitForCondition( _rsm, timeout_ms, [rids, count, &nb_done]()
+    {
+        // resources never go back to LOADING, so already finished prefix doesn't have to be checked again
+        while( nb_done < count && IsDone( _rsm, { rids[nb_done].i } ) )
+            ++nb_done;
+
+        return nb_done == count;
+    } );
+}
 
-    return _rsm->rstate[id.index];
+uint32_t RSM::WaitAny( const RSMResourceID* rids, uint32_t count, uint32_t timeout_ms )
+{
+    uint32_t found = RSM_WAIT_TIMEOUT;
+    WaitForCondition( _rsm, timeout_ms, [rids, count, &found]()
+    {
+        for( uint32_t i = 0; i < count; ++i )
+        {
+            if( IsDone( _rsm, { rids[i].i } ) )
+            {
+                found = i;
+                return true;
+            }
+        }
+        return false;
+    } );
+    return found;
 }
 
 RSMResourceID RSM::Find( const char* relative_path )
@@ -420,7 +1816,7 @@ bool RSM::IsAlive( RSMResourceID id )
 RSMEState::E RSM::State( RSMResourceID id )
 {
     id_t iid = { id.i };
-    return _rsm->IsAlive( iid ) ? _rsm->rstate[iid.index] : RSMEState::UNLOADED;
+    return _rsm->IsAlive( iid ) ? _rsm->rstate[iid.index].load( std::memory_order_acquire ) : RSMEState::UNLOADED;
 }
 
 const void* RSM::Get( RSMResourceID id )
@@ -435,23 +1831,17 @@ bool RSM::Release( RSMResourceID id )
     if( _rsm->IsAlive( iid ) )
     {
         RSMResourceHash rhash = _rsm->rhash[iid.index];
-        if( LookupRemove( _rsm, rhash ) )
+        const RSMELookupRemove::E result = LookupRemove( _rsm, rhash, iid );
+        if( result == RSMELookupRemove::CACHED )
+        {
+            EvictCached( _rsm );
+            return true;
+        }
+        else if( result == RSMELookupRemove::REMOVED )
         {
             if( _rsm->rflags[iid.index] & RSMEInternalState::MANAGED )
             {
-                _rsm->rstate[iid.index] = RSMEState::UNLOADING;
-                {
-                    scope_mutex_t guard( _rsm->id_lock );
-                    iid = id_table::invalidate( _rsm->id_alloc, iid );
-                }
-
-                RSMPendingResource pending = {};
-                pending.id = iid;
-                {
-                    scope_mutex_t guard( _rsm->to_unload_lock );
-                    queue::push_back( _rsm->to_unload, pending );
-                }
-                _rsm->sema.signal();
+                QueueUnload( _rsm, iid );
             }
             else
             {
@@ -489,6 +1879,471 @@ void RSM::Acquire( RSMResourceID id )
     }
 }
 
+void RSM::AcquireBatch( const RSMResourceID* ids, uint32_t count )
+{
+    RSMImpl* rsm = _rsm;
+
+    // referenced resources are acquired without locks. Cached ones have to be revived under lookup_lock
+    small_array_t<id_t, RSM_BATCH_INLINE> revive( rsm->pending_resources_allocator );
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        const id_t iid = { ids[i].i };
+        if( rsm->IsAlive( iid ) && !TryAddRef( rsm, iid ) )
+        {
+            array::push_back( revive, iid );
+        }
+    }
+
+    if( array::empty( revive ) )
+        return;
+
+    scope_mutex_t guard( rsm->lookup_lock );
+    for( const id_t iid : revive )
+    {
+        if( rsm->lookup.Find( rsm->rhash[iid.index].h ) == iid )
+        {
+            LookupRevive( rsm, iid );
+        }
+    }
+}
+
+uint32_t RSM::ReleaseBatch( const RSMResourceID* ids, uint32_t count )
+{
+    RSMImpl* rsm = _rsm;
+
+    // references are dropped without locks. Resources which reached zero are cached or removed under one lookup_lock
+    small_array_t<id_t, RSM_BATCH_INLINE> dropped( rsm->pending_resources_allocator );
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        const id_t iid = { ids[i].i };
+        if( rsm->IsAlive( iid ) && LookupDropRef( rsm, iid ) )
+        {
+            array::push_back( dropped, iid );
+        }
+    }
+
+    if( array::empty( dropped ) )
+        return 0;
+
+    id_t* to_unload = dropped.data;
+    small_array_t<id_t, RSM_BATCH_INLINE> to_remove( rsm->pending_resources_allocator );
+    uint32_t nb_unload = 0;
+    uint32_t nb_cached = 0;
+    {
+        scope_mutex_t guard( rsm->lookup_lock );
+        for( uint32_t i = 0; i < dropped.size; ++i )
+        {
+            const id_t iid = dropped[i];
+            const RSMELookupRemove::E result = LookupRemoveLocked( rsm, rsm->rhash[iid.index], iid );
+            if( result == RSMELookupRemove::CACHED )
+            {
+                nb_cached += 1;
+            }
+            else if( result == RSMELookupRemove::REMOVED )
+            {
+                // nb_unload <= i, so compacting in place doesn't overwrite unvisited ids
+                if( rsm->rflags[iid.index] & RSMEInternalState::MANAGED )
+                    to_unload[nb_unload++] = iid;
+                else
+                    array::push_back( to_remove, iid );
+            }
+        }
+    }
+    const uint32_t nb_remove = to_remove.size;
+
+    if( nb_unload )
+    {
+        QueueUnloads( rsm, to_unload, nb_unload );
+    }
+    if( nb_remove )
+    {
+        RemoveResourceEntries( rsm, to_remove.data, nb_remove );
+    }
+    if( nb_cached )
+    {
+        EvictCached( rsm );
+    }
+
+    return nb_unload + nb_remove + nb_cached;
+}
+
+// retired lookup tables have no loader, only memory is freed
+static void UnloadRetired( RSMImpl* rsm, const RSMRetiredResource& retired )
+{
+    RSMResourceData data = retired.data;
+    if( retired.loader_index != RSMImpl::INVALID_LOADER_INDEX )
+    {
+        rsm->loader[retired.loader_index]->Unload( &data );
+    }
+    if( data.allocator )
+    {
+        BX_FREE( data.allocator, (void*)data.pointer );
+    }
+}
+
+static void RetireLookupTables( RSMImpl* rsm )
+{
+    scope_mutex_t guard( rsm->lookup_lock );
+    for( RSMLookupTable::Table* table : rsm->retired_lookup )
+    {
+        RSMRetiredResource retired = {};
+        retired.data.pointer = table;
+        retired.data.allocator = rsm->lookup.allocator;
+        retired.unload_frame = rsm->frame + RSM_RETIRE_FRAMES;
+        retired.loader_index = RSMImpl::INVALID_LOADER_INDEX;
+        array::push_back( rsm->retired, retired );
+    }
+    array::clear( rsm->retired_lookup );
+}
+
+static void UpdateHotReload( RSMImpl* rsm )
+{
+    RetireLookupTables( rsm );
+
+    // swap in reloaded data. Old data stays alive for a few frames
+    RSMReloadedResource reloaded = {};
+    while( PopFrontQueue( &reloaded, rsm->reloaded, rsm->reloaded_lock ) )
+    {
+        const id_t id = reloaded.id;
+        if( !rsm->IsAlive( id ) )
+        {
+            if( reloaded.ok )
+            {
+                SYS_LOG_WARNING( "Reloaded resource was released in the meantime" );
+
+                RSMRetiredResource retired = {};
+                retired.data = reloaded.data;
+                retired.loader_index = reloaded.loader_index;
+                UnloadRetired( rsm, retired );
+            }
+            continue;
+        }
+
+        rsm->rflags[id.index] &= ~RSMEInternalState::RELOADING;
+        if( !reloaded.ok )
+        {
+            SYS_LOG_ERROR( "Resource failed to reload (%s). Keeping previous version", rsm->rname[id.index].c_str() );
+            continue;
+        }
+
+        RSMRetiredResource retired = {};
+        retired.data = rsm->rdata[id.index];
+        retired.unload_frame = rsm->frame + RSM_RETIRE_FRAMES;
+        retired.loader_index = rsm->rloader_index[id.index];
+        array::push_back( rsm->retired, retired );
+
+        {
+            scope_mutex_t guard( rsm->lookup_lock );
+            if( RefCount( rsm, id.index ) == 0 )
+            {
+                // cached, so size of cache changes
+                rsm->lru_bytes -= retired.data.size;
+                rsm->lru_bytes += reloaded.data.size;
+            }
+            rsm->rdata[id.index] = reloaded.data;
+        }
+        rsm->type_counters[retired.loader_index].bytes_resident += reloaded.data.size;
+        rsm->type_counters[retired.loader_index].bytes_resident -= retired.data.size;
+        rsm->rversion[id.index] += 1;
+        SYS_LOG_INFO( "Resource reloaded (%s)", rsm->rname[id.index].c_str() );
+    }
+
+    for( int32_t i = (int32_t)array::size( rsm->retired ) - 1; i >= 0; --i )
+    {
+        const bool is_lookup = rsm->retired[i].loader_index == RSMImpl::INVALID_LOADER_INDEX;
+        if( rsm->retired[i].unload_frame <= rsm->frame && (!is_lookup || rsm->lookup.NoReaders()) )
+        {
+            UnloadRetired( rsm, rsm->retired[i] );
+            array::erase_swap( rsm->retired, i );
+        }
+    }
+
+    if( !rsm->hot_reload )
+        return;
+
+    string_buffer_t changed;
+    string::create( &changed, 256, rsm->main_allocator );
+    if( rsm->filesystem->PollChanges( &changed ) == 0 )
+        return;
+
+    for( string_buffer_it it = string::iterate( changed ); !it.null(); it = string::iterate( changed, it ) )
+    {
+        const RSMResourceHash rhash = RSM::CreateHash( it.pointer );
+        const id_t id = rsm->lookup.Find( rhash.h );
+        if( !rsm->IsAlive( id ) )
+            continue;
+
+        const uint32_t index = id.index;
+        const bool can_reload = (rsm->rflags[index] & RSMEInternalState::MANAGED) 
+            && (rsm->rflags[index] & RSMEInternalState::RELOADING) == 0
+            && rsm->rstate[index] == RSMEState::READY
+            && rsm->loader[rsm->rloader_index[index]]->Streaming() == nullptr;
+        if( !can_reload )
+            continue;
+
+        rsm->rflags[index] |= RSMEInternalState::RELOADING;
+
+        RSMLoader* loader = rsm->loader[rsm->rloader_index[index]];
+        BXPostLoadCallback post_load_cb( FileReloadCallback, rsm, (void*)(uintptr_t)id.hash, rsm->rsystem[index] );
+        const BXEFIleMode::E mode = (loader->IsBinary()) ? BXEFIleMode::BIN : BXEFIleMode::TXT;
+        rsm->filesystem->LoadFile( rsm->rname[index].c_str(), mode, post_load_cb, rsm->default_resource_allocator );
+    }
+}
+
+void RSM::Update( uint32_t unload_budget )
+{
+    _rsm->frame += 1;
+    UpdateHotReload( _rsm );
+    UpdatePrefetch( _rsm );
+
+    RSMPendingResource pending = {};
+    while( PopFrontQueue( &pending, _rsm->main_thread_load, _rsm->main_thread_load_lock ) )
+    {
+        ProcessLoad( _rsm, pending );
+    }
+    while( PopFrontQueue( &pending, _rsm->unload_overflow, _rsm->unload_overflow_lock ) )
+    {
+        ProcessUnload( _rsm, pending );
+    }
+
+    // size is approximate, more entries can arrive in the meantime but never less (main thread is only consumer)
+    const uint32_t nb_unloads = min_of_2( _rsm->to_unload.size(), unload_budget );
+    if( nb_unloads == 0 )
+        return;
+
+    RSMPendingResource* batch = (RSMPendingResource*)BX_MALLOC( _rsm->pending_resources_allocator, nb_unloads * sizeof( RSMPendingResource ), ALIGNOF( RSMPendingResource ) );
+    uint32_t batch_size = 0;
+    for( uint32_t i = 0; i < nb_unloads; ++i )
+    {
+        if( !_rsm->to_unload.pop( &pending ) )
+            break;
+
+        uint32_t loader_index = 0;
+        RSMLoader* loader = PendingLoader( _rsm, pending, &loader_index );
+        if( loader && loader->MainThreadOnly() )
+        {
+            ProcessUnload( _rsm, pending );
+        }
+        else
+        {
+            batch[batch_size++] = pending;
+        }
+    }
+
+    if( batch_size == 0 )
+    {
+        BX_FREE( _rsm->pending_resources_allocator, batch );
+        return;
+    }
+
+    RSMImpl* rsm = _rsm;
+    rsm->nb_jobs_in_flight += 1;
+    JOBTaskID task = JOB::Create( "RSMUnload", [rsm, batch]( const JOBRange range, const JOBContext& ctx )
+    {
+        for( uint32_t i = range.begin; i < range.end; ++i )
+        {
+            ProcessUnload( rsm, batch[i] );
+        }
+    }, JOBSplit::Worker( batch_size, JOB::GetThreadCount() ),
+    [rsm, batch]( const JOBRange range, const JOBContext& ctx )
+    {
+        BX_FREE( rsm->pending_resources_allocator, batch );
+        JobFinished( rsm );
+    } );
+    JOB::Spawn( task, JOBPriority::LOW );
+}
+
+void RSM::EnableHotReload( bool enable )
+{
+    _rsm->hot_reload = enable;
+    _rsm->filesystem->WatchChanges( enable );
+}
+
+uint32_t RSM::Version( RSMResourceID id )
+{
+    id_t iid = { id.i };
+    return _rsm->IsAlive( iid ) ? _rsm->rversion[iid.index] : 0;
+}
+
+void RSM::SetCacheBudget( uint64_t bytes )
+{
+    {
+        scope_mutex_t guard( _rsm->lookup_lock );
+        _rsm->lru_budget = bytes;
+    }
+    EvictCached( _rsm );
+}
+
+uint64_t RSM::CacheSize()
+{
+    scope_mutex_t guard( _rsm->lookup_lock );
+    return _rsm->lru_bytes;
+}
+
+void RSM::StartRecording( const char* manifest_relative_path )
+{
+    scope_mutex_t guard( _rsm->record_lock );
+    string::create( &_rsm->record_path, manifest_relative_path, _rsm->string_allocator );
+    string::create( &_rsm->record, 4096, _rsm->main_allocator );
+    hash::clear( _rsm->record_seen );
+    _rsm->record_start_ms = BXTime::GlobalTimeMS();
+    _rsm->is_recording = true;
+}
+
+bool RSM::StopRecording()
+{
+    scope_mutex_t guard( _rsm->record_lock );
+    if( !_rsm->is_recording )
+        return false;
+
+    _rsm->is_recording = false;
+    if( _rsm->record._offset )
+    {
+        _rsm->filesystem->WriteFileAsync( _rsm->record_path.c_str(), _rsm->record._base, _rsm->record._offset );
+    }
+    string::free( &_rsm->record );
+    string::free( &_rsm->record_path );
+    hash::clear( _rsm->record_seen );
+    return true;
+}
+
+uint32_t RSM::Prefetch( const char* manifest_relative_path, void* system )
+{
+    BXIFilesystem* fs = _rsm->filesystem;
+    BXFileHandle hfile = fs->LoadFile( manifest_relative_path, BXEFIleMode::TXT, _rsm->main_allocator );
+    fs->Wait( hfile );
+
+    BXFile file = {};
+    if( fs->File( &file, hfile ) != BXEFileStatus::READY )
+    {
+        fs->CloseFile( &hfile );
+        return 0;
+    }
+
+    string::create( &_rsm->prefetch, file.size + 1, _rsm->main_allocator );
+    _rsm->prefetch_system = system;
+
+    // each line: <milliseconds since recording started> <relative path>. Manifest is ordered by time already
+    uint32_t count = 0;
+    const char* current = file.txt;
+    const char* end = file.txt + file.size;
+    while( current < end )
+    {
+        const char* line_end = current;
+        while( line_end < end && *line_end != '\n' && *line_end != '\r' && *line_end )
+            ++line_end;
+
+        const char* path = current;
+        while( path < line_end && *path != ' ' )
+            ++path;
+        while( path < line_end && *path == ' ' )
+            ++path;
+
+        if( path < line_end )
+        {
+            string::appendn( &_rsm->prefetch, path, (unsigned)(line_end - path) );
+            ++count;
+        }
+
+        current = line_end;
+        while( current < end && (*current == '\n' || *current == '\r') )
+            ++current;
+        if( current < end && *current == 0 )
+            break;
+    }
+    fs->CloseFile( &hfile );
+
+    _rsm->prefetch_it = (count) ? string::iterate( _rsm->prefetch ) : string_buffer_it();
+    return count;
+}
+
+uint32_t RSM::LoadStats( RSMLoadStats* stats, uint32_t max_stats )
+{
+    const uint32_t count = min_of_2( max_stats, _rsm->nb_loaders );
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        const RSMTypeCounters& counters = _rsm->type_counters[i];
+        RSMLoadStats& out = stats[i];
+        out.type = _rsm->loader[i]->SupportedType();
+        out.nb_loads = counters.nb_loads.load( std::memory_order_relaxed );
+        out.nb_failed = counters.nb_failed.load( std::memory_order_relaxed );
+        out.queue_us = counters.queue_us.load( std::memory_order_relaxed );
+        out.io_us = counters.io_us.load( std::memory_order_relaxed );
+        out.cpu_us = counters.cpu_us.load( std::memory_order_relaxed );
+        out.bytes_read = counters.bytes_read.load( std::memory_order_relaxed );
+        out.bytes_resident = counters.bytes_resident.load( std::memory_order_relaxed );
+        for( uint32_t b = 0; b < RSMLoadStats::HISTOGRAM_SIZE; ++b )
+            out.histogram[b] = counters.histogram[b].load( std::memory_order_relaxed );
+    }
+    return count;
+}
+
+uint32_t RSM::SlowestLoads( RSMSlowLoad* loads, uint32_t max_loads )
+{
+    scope_mutex_t guard( _rsm->slowest_lock );
+    const uint32_t count = min_of_2( max_loads, _rsm->nb_slowest );
+    
+    RSMSlowLoad sorted[RSMSlowLoad::MAX_COUNT];
+    memcpy( sorted, _rsm->slowest, _rsm->nb_slowest * sizeof( RSMSlowLoad ) );
+    std::sort( sorted, sorted + _rsm->nb_slowest, []( const RSMSlowLoad& a, const RSMSlowLoad& b ) { return a.total_us > b.total_us; } );
+    memcpy( loads, sorted, count * sizeof( RSMSlowLoad ) );
+    return count;
+}
+
+void RSM::DumpLoadStats()
+{
+    RSMLoadStats stats[RSMImpl::MAX_TYPES];
+    const uint32_t nb_stats = LoadStats( stats, RSMImpl::MAX_TYPES );
+    
+    SYS_LOG_INFO( "Resource load stats (times in ms)\n" );
+    for( uint32_t i = 0; i < nb_stats; ++i )
+    {
+        const RSMLoadStats& st = stats[i];
+        if( st.nb_loads == 0 )
+            continue;
+        
+        SYS_LOG_INFO( " %-8s loads: %llu failed: %llu queue: %.2f io: %.2f cpu: %.2f read: %llu KB resident: %llu KB\n",
+            st.type, st.nb_loads, st.nb_failed, st.queue_us / 1000.0, st.io_us / 1000.0, st.cpu_us / 1000.0, st.bytes_read >> 10, st.bytes_resident >> 10 );
+
+        char histogram[RSMLoadStats::HISTOGRAM_SIZE * 12] = {};
+        uint32_t offset = 0;
+        for( uint32_t b = 0; b < RSMLoadStats::HISTOGRAM_SIZE; ++b )
+        {
+            offset += snprintf( histogram + offset, sizeof( histogram ) - offset, " %llu", st.histogram[b] );
+        }
+        SYS_LOG_INFO( "   histogram (<1, <2, <4 ... ms):%s\n", histogram );
+    }
+
+    RSMSlowLoad slowest[RSMSlowLoad::MAX_COUNT];
+    const uint32_t nb_slowest = SlowestLoads( slowest, RSMSlowLoad::MAX_COUNT );
+    SYS_LOG_INFO( "Slowest loads\n" );
+    for( uint32_t i = 0; i < nb_slowest; ++i )
+    {
+        const RSMSlowLoad& load = slowest[i];
+        SYS_LOG_INFO( " %8.2f (queue: %.2f io: %.2f cpu: %.2f) %s\n", load.total_us / 1000.0, load.queue_us / 1000.0, load.io_us / 1000.0, load.cpu_us / 1000.0, load.name );
+    }
+}
+
+void RSM::ResetLoadStats()
+{
+    for( RSMTypeCounters& counters : _rsm->type_counters )
+    {
+        // resident bytes describe current state, not history
+        counters.nb_loads = 0;
+        counters.nb_failed = 0;
+        counters.queue_us = 0;
+        counters.io_us = 0;
+        counters.cpu_us = 0;
+        counters.bytes_read = 0;
+        for( std::atomic_uint64_t& bucket : counters.histogram )
+            bucket = 0;
+    }
+
+    scope_mutex_t guard( _rsm->slowest_lock );
+    _rsm->nb_slowest = 0;
+    _rsm->slowest_threshold_us = 0;
+}
+
 BXIFilesystem* RSM::Filesystem()
 {
     return _rsm->filesystem;
@@ -504,7 +2359,7 @@ void RSM::Internal_AddLoader( RSMLoaderCreator* creator )
         _rsm->loader[loader_index] = loader;
 
         const char* type = loader->SupportedType();
-        _rsm->loader_supported_type[loader_index] = ResourceTypeHash( type );
+        _rsm->loader_supported_type[loader_index] = Internal_TypeHash( type, (uint32_t)strlen( type ) );
     }
 }
 
@@ -513,7 +2368,7 @@ void RSM::StartUp( BXIFilesystem* filesystem, BXIAllocator* allocator )
     uint32_t mem_size = 0;
     mem_size += sizeof( RSMImpl );
 
-    void* memory = BX_MALLOC( allocator, mem_size, 8 );
+    void* memory = BX_MALLOC( allocator, mem_size, ALIGNOF( RSMImpl ) );
     RSMImpl* rsm = new(memory) RSMImpl();
 
     rsm->filesystem = filesystem;
@@ -523,8 +2378,18 @@ void RSM::StartUp( BXIFilesystem* filesystem, BXIAllocator* allocator )
     rsm->default_resource_allocator = allocator;
     rsm->pending_resources_allocator = allocator;
 
-    queue::set_allocator( rsm->to_load, rsm->pending_resources_allocator );
-    queue::set_allocator( rsm->to_unload, rsm->pending_resources_allocator );
+    rsm->lookup.StartUp( allocator );
+
+    rsm->to_load.create( RSM_MAX_RESOURCES, rsm->pending_resources_allocator );
+    rsm->to_unload.create( RSM_MAX_RESOURCES, rsm->pending_resources_allocator );
+    queue::set_allocator( rsm->main_thread_load, rsm->pending_resources_allocator );
+    queue::set_allocator( rsm->unload_overflow, rsm->pending_resources_allocator );
+    queue::set_allocator( rsm->reloaded, rsm->pending_resources_allocator );
+    rsm->prefetch_in_flight.allocator = rsm->pending_resources_allocator;
+    rsm->retired.allocator = rsm->pending_resources_allocator;
+    rsm->retired_lookup.allocator = rsm->pending_resources_allocator;
+    for( queue_t<RSMPendingResource>& deferred : rsm->deferred_load )
+        queue::set_allocator( deferred, rsm->pending_resources_allocator );
 
     rsm->is_running = 1;
     rsm->background_thread = std::thread( BackgroundThread, rsm );
@@ -539,10 +2404,66 @@ void RSM::ShutDown()
 
     RSMImpl* rsm = _rsm;
 
+    StopRecording();
+    for( RSMResourceID id : rsm->prefetch_in_flight )
+    {
+        Release( id );
+    }
+    array::clear( rsm->prefetch_in_flight );
+    rsm->prefetch_it = string_buffer_it();
+
+    SetCacheBudget( 0 );
+
     rsm->is_running = 0;
     rsm->sema.signal();
     rsm->background_thread.join();
 
+    {
+        std::unique_lock<std::mutex> guard( rsm->jobs_lock );
+        rsm->jobs_done_cv.wait( guard, [rsm]() { return rsm->nb_jobs_in_flight.load() == 0; } );
+    }
+
+    // whatever is still pending is processed inline
+    for( queue_t<RSMPendingResource>& deferred : rsm->deferred_load )
+    {
+        while( !queue::empty( deferred ) )
+        {
+            ProcessLoad( rsm, queue::front( deferred ) );
+            queue::pop_front( deferred );
+        }
+    }
+
+    RSMPendingResource pending = {};
+    while( rsm->to_load.pop( &pending ) )
+        ProcessLoad( rsm, pending );
+
+    while( PopFrontQueue( &pending, rsm->main_thread_load, rsm->main_thread_load_lock ) )
+        ProcessLoad( rsm, pending );
+
+    RSMReloadedResource reloaded = {};
+    while( PopFrontQueue( &reloaded, rsm->reloaded, rsm->reloaded_lock ) )
+    {
+        if( reloaded.ok )
+        {
+            RSMRetiredResource retired = {};
+            retired.data = reloaded.data;
+            retired.loader_index = reloaded.loader_index;
+            UnloadRetired( rsm, retired );
+        }
+    }
+    RetireLookupTables( rsm );
+    for( const RSMRetiredResource& retired : rsm->retired )
+    {
+        UnloadRetired( rsm, retired );
+    }
+    array::clear( rsm->retired );
+
+    while( rsm->to_unload.pop( &pending ) )
+        ProcessUnload( rsm, pending );
+
+    while( PopFrontQueue( &pending, rsm->unload_overflow, rsm->unload_overflow_lock ) )
+        ProcessUnload( rsm, pending );
+
     for( uint32_t i = 0; i < rsm->nb_loaders; ++i )
     {
         BX_DELETE0( rsm->main_allocator, rsm->loader[i] );
@@ -552,10 +2473,10 @@ void RSM::ShutDown()
     if( id_table::size( rsm->id_alloc ) > 0 )
     {
         SYS_LOG_ERROR( "There are still loaded resources!!!" );
-        for( uint32_t i = 0; i < RSMImpl::MAX_RESOURCES; ++i )
+        for( uint32_t i = 0; i < rsm->Capacity(); ++i )
         {
-            const string_t& name = rsm->rname[i];
-            if( name.c_str() && string::length( name.c_str() ) )
+            const interned_string_t name = rsm->rname[i];
+            if( !name.empty() )
             {
                 SYS_LOG_INFO( " -- %s\n", name.c_str() );
             }
@@ -563,6 +2484,8 @@ void RSM::ShutDown()
         system( "PAUSE" );
     }
 
+    FreePages( rsm );
+    rsm->lookup.ShutDown();
     InvokeDestructor( rsm );
     
     BXIAllocator* allocator = rsm->main_allocator;
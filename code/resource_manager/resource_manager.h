@@ -1,6 +1,8 @@
 #pragma once
 
 #include <foundation/type.h>
+#include <foundation/hash.h>
+#include <foundation/tag.h>
 #include "resource_loader.h"
 
 struct BXIFilesystem;
@@ -22,6 +24,9 @@ struct RSMResourceHash
 {
     uint64_t h;
 };
+static constexpr uint32_t RSM_WAIT_INFINITE = UINT32_MAX;
+static constexpr uint32_t RSM_WAIT_TIMEOUT = UINT32_MAX;
+
 struct RSMResourceID
 {
     uint32_t i;
@@ -29,14 +34,57 @@ struct RSMResourceID
     static constexpr RSMResourceID Null() { return { 0 }; }
 };
 
+// Load stats of one resource type. Times are sums in microseconds
+//  - io: from Load call until file is read (includes waiting in filesystem queue)
+//  - queue: from file read until loader is called (includes waiting for dependencies)
+//  - cpu: time spent in loader
+struct RSMLoadStats
+{
+    static constexpr uint32_t HISTOGRAM_SIZE = 16; // bucket 'i' counts loads which took less than 2^i ms in total
+
+    const char* type = nullptr;
+    uint64_t nb_loads = 0;
+    uint64_t nb_failed = 0;
+    uint64_t queue_us = 0;
+    uint64_t io_us = 0;
+    uint64_t cpu_us = 0;
+    uint64_t bytes_read = 0;
+    uint64_t bytes_resident = 0; // currently loaded
+    uint64_t histogram[HISTOGRAM_SIZE] = {};
+};
+
+struct RSMSlowLoad
+{
+    static constexpr uint32_t MAX_COUNT = 32;
+
+    char name[96];
+    uint64_t total_us;
+    uint64_t queue_us;
+    uint64_t io_us;
+    uint64_t cpu_us;
+    uint64_t bytes_read;
+    uint64_t bytes_resident;
+};
+
 namespace RSM
 {
-    RSMResourceHash CreateHash( const char* relative_path );
+    // Hash is computed from path only, so it's the same at compile time and at runtime. Assign to constexpr variable
+    // to get hash of literal path for free and use it with Find/Acquire:
+    //   static constexpr RSMResourceHash SHADER = RSM::CreateHash( "shader/hlsl/bin/base.shader" );
+    constexpr RSMResourceHash CreateHash( const char* relative_path );
 
     RSMResourceID Load( const char* relative_path, void* system = nullptr );
+    // Load of many resources at once. Each lock is taken once per batch and files are sent to filesystem in one request.
+    // 'out_ids' is filled in 'relative_paths' order (null id for unsupported type). Returns number of valid ids
+    uint32_t      LoadBatch( RSMResourceID* out_ids, const char* const* relative_paths, uint32_t count, void* system = nullptr );
     RSMResourceID Create( const char* name, const void* data );
     RSMResourceID Create( const void* data );
-    RSMEState::E  Wait( RSMResourceID rid );
+
+    // Block calling thread until resources leave LOADING state. Waiters sleep, they are woken up each time any resource finishes.
+    // Wait returns state of resource, WaitAll returns false on timeout, WaitAny returns index of finished resource or RSM_WAIT_TIMEOUT
+    RSMEState::E  Wait( RSMResourceID rid, uint32_t timeout_ms = RSM_WAIT_INFINITE );
+    bool          WaitAll( const RSMResourceID* rids, uint32_t count, uint32_t timeout_ms = RSM_WAIT_INFINITE );
+    uint32_t      WaitAny( const RSMResourceID* rids, uint32_t count, uint32_t timeout_ms = RSM_WAIT_INFINITE );
 
     RSMResourceID Find( const char* relative_path );
     RSMResourceID Find( RSMResourceHash hash );
@@ -54,9 +102,51 @@ namespace RSM
         RSMResourceID rid = Find( relative_path );
         return IsAlive( rid ) ? Get( rid ) : nullptr;
     }
+    inline const void* Acquire( RSMResourceHash hash )
+    {
+        RSMResourceID rid = Find( hash );
+        return IsAlive( rid ) ? Get( rid ) : nullptr;
+    }
 
     void Acquire( RSMResourceID id );
 
+    // the same as Acquire/Release called for each id, but locks are taken once per batch. 
+    // ReleaseBatch returns number of resources which ref count has reached zero
+    void     AcquireBatch( const RSMResourceID* ids, uint32_t count );
+    uint32_t ReleaseBatch( const RSMResourceID* ids, uint32_t count );
+
+    // call once per frame from main thread. Runs loads of main thread only loaders and 
+    // dispatches at most 'unload_budget' pending unloads to job system
+    void Update( uint32_t unload_budget = 64 );
+
+    // Watches filesystem root and reloads changed resources in background. New data is swapped in by Update,
+    // so pointer returned by Get can change between frames. Previous data is kept alive for a few frames.
+    // Off by default. Engine enables it with -hot_reload on command line. Ids stay valid across reload, Version tells it happened
+    void EnableHotReload( bool enable );
+    // incremented each time resource is reloaded
+    uint32_t Version( RSMResourceID id );
+
+    // Released resources are kept loaded while total size of them fits in budget, so next Load of the same path
+    // is instant. Least recently released are unloaded first. Size is taken from RSMResourceData::size.
+    // Number of cached resources is limited too, because each of them keeps its id. Zero budget disables cache
+    void SetCacheBudget( uint64_t bytes );
+    uint64_t CacheSize();
+
+    // Records path of every resource loaded for the first time, in order, to manifest written on StopRecording.
+    // Prefetch replays manifest in background from Update (a few loads at a time, so it doesn't delay game requests).
+    // Prefetched resources end up in cache, so they have to fit in cache budget. 'system' is passed to every loader.
+    // Returns number of resources to prefetch
+    void     StartRecording( const char* manifest_relative_path );
+    bool     StopRecording();
+    uint32_t Prefetch( const char* manifest_relative_path, void* system = nullptr );
+
+    // LoadStats returns number of resource types. SlowestLoads returns loads ordered from the slowest one.
+    // Counters are updated without locks, so snapshot can be taken any time
+    uint32_t LoadStats( RSMLoadStats* stats, uint32_t max_stats );
+    uint32_t SlowestLoads( RSMSlowLoad* loads, uint32_t max_loads );
+    void     DumpLoadStats();
+    void     ResetLoadStats();
+
    
     template<typename T>
     inline void RegisterLoader() { Internal_AddLoader( T::Internal_Creator ); }
@@ -65,11 +155,53 @@ namespace RSM
 
     BXIFilesystem* Filesystem();
     void Internal_AddLoader( RSMLoaderCreator* creator );
+    constexpr uint32_t Internal_TypeHash( const char* type, uint32_t length );
     
     void StartUp( BXIFilesystem* filesystem, BXIAllocator* allocator );
     void ShutDown( );
 }//
 
+namespace RSM
+{
+    constexpr uint32_t Internal_TypeHash( const char* type, uint32_t length )
+    {
+        return constexpr_hash::murmur3_hash32( type, length, tag32_t( "RSMR" ) );
+    }
+
+    // path is 'name.type'. Type ends at first ' ', '.' or new line
+    constexpr RSMResourceHash CreateHash( const char* relative_path )
+    {
+        const uint32_t MAX_NAME_LENGTH = 254;
+        const uint32_t MAX_TYPE_LENGTH = 30;
+
+        const char* name = relative_path;
+        while( *name == '.' )
+            ++name;
+
+        uint32_t name_len = 0;
+        while( name[name_len] && name[name_len] != '.' )
+            ++name_len;
+        name_len = ( name_len < MAX_NAME_LENGTH ) ? name_len : MAX_NAME_LENGTH;
+
+        const char* type = name + name_len;
+        uint32_t type_len = 0;
+        if( *type )
+        {
+            while( *type == ' ' || *type == '.' || *type == '\n' )
+                ++type;
+            while( type[type_len] && type[type_len] != ' ' && type[type_len] != '.' && type[type_len] != '\n' )
+                ++type_len;
+            type_len = ( type_len < MAX_TYPE_LENGTH ) ? type_len : MAX_TYPE_LENGTH;
+        }
+
+        const uint32_t type_hash = Internal_TypeHash( type, type_len );
+        const uint32_t crc = constexpr_hash::crc32n( name, name_len, type_hash );
+        const uint32_t name_hash = constexpr_hash::murmur3_hash32( name, name_len, type_hash + name_len ) ^ crc;
+
+        return { (uint64_t)type_hash | ( (uint64_t)name_hash << 32 ) };
+    }
+}//
+
 struct RSMLoadState
 {
     uint32_t nb_loaded = 0;